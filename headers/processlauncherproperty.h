@@ -0,0 +1,38 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+
+#ifndef PROCESSLAUNCHERPROPERTY_H
+#define PROCESSLAUNCHERPROPERTY_H
+
+/*
+ * Name of the QCoreApplication property holding the process launcher.
+ * The compositor sets it and the launcher plugin, loaded in the same
+ * process, reads it to start applications without going through D-Bus.
+ */
+#define PROCESS_LAUNCHER_PROPERTY "processLauncher"
+
+#endif // PROCESSLAUNCHERPROPERTY_H
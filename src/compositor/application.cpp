@@ -32,6 +32,7 @@
 #include <QtGui/QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include <QStandardPaths>
 
 #include <qt5xdg/xdgautostart.h>
@@ -43,9 +44,12 @@
 #include "onscreendisplay.h"
 #include "multimediakeys/multimediakeys.h"
 #include "processlauncher/processlauncher.h"
+#include "processlauncherproperty.h"
 #include "qmlregistration.h"
+#include "sessionmanager/autostartscheduler.h"
 #include "sessionmanager/sessionmanager.h"
 #include "sigwatch.h"
+#include "startuptrace.h"
 
 #if HAVE_SYSTEMD
 #  include <systemd/sd-daemon.h>
@@ -110,8 +114,14 @@ Application::Application(QObject *parent)
     // Multimedia keys
     m_multimediaKeys = new MultimediaKeys(this);
 
-    // Process launcher
+    // Process launcher, also published to the launcher plugin so that
+    // it doesn't have to go through D-Bus to reach us
     m_launcher = new ProcessLauncher(this);
+    QCoreApplication::instance()->setProperty(PROCESS_LAUNCHER_PROPERTY,
+                                              QVariant::fromValue<QObject *>(m_launcher));
+
+    // Autostart
+    m_autostart = new AutostartScheduler(m_launcher, this);
 
     // Session manager
     m_sessionManager = new SessionManager(this);
@@ -227,23 +237,35 @@ void Application::startup()
     if (m_started)
         return;
 
+    StartupTrace::begin("startup");
+
     // Check whether XDG_RUNTIME_DIR is ok or not
+    StartupTrace::begin("verifyXdgRuntimeDir");
     verifyXdgRuntimeDir();
+    StartupTrace::end("verifyXdgRuntimeDir");
 
     // Register D-Bus service
+    StartupTrace::begin("registerService");
     if (!QDBusConnection::sessionBus().registerService(QStringLiteral("io.liri.Session"))) {
         qWarning("Failed to register D-Bus service: %s",
                  qPrintable(QDBusConnection::sessionBus().lastError().message()));
         QCoreApplication::exit(1);
     }
+    StartupTrace::end("registerService");
 
     // Session manager
+    StartupTrace::begin("SessionManager::registerWithDBus");
     if (!m_sessionManager->registerWithDBus())
         QCoreApplication::exit(1);
+    StartupTrace::end("SessionManager::registerWithDBus");
 
     // Process launcher
+    StartupTrace::begin("ProcessLauncher::registerWithDBus");
     if (!ProcessLauncher::registerWithDBus(m_launcher))
         QCoreApplication::exit(1);
+    StartupTrace::end("ProcessLauncher::registerWithDBus");
+
+    StartupTrace::begin("contextProperties");
 
     // Set platform name
     m_appEngine->rootContext()->setContextProperty(QStringLiteral("platformName"),
@@ -264,8 +286,15 @@ void Application::startup()
     m_appEngine->rootContext()->setContextProperty(QLatin1String("OnScreenDisplay"),
                                                    new OnScreenDisplay(this));
 
+    StartupTrace::end("contextProperties");
+
+    // Time to first frame on every output, as soon as windows are created
+    StartupTrace::watchWindows();
+
     // Load the compositor
+    StartupTrace::begin("QQmlApplicationEngine::load");
     m_appEngine->load(m_url);
+    StartupTrace::end("QQmlApplicationEngine::load");
 
     // Set Wayland socket name
     QObject *rootObject = m_appEngine->rootObjects().at(0);
@@ -295,16 +324,30 @@ void Application::startup()
         qunsetenv("QT_SCALE_FACTOR");
         qunsetenv("QT_SCREEN_SCALE_FACTORS");
         qputenv("QT_AUTO_SCREEN_SCALE_FACTOR", QByteArrayLiteral("1"));
+
+        // Children environment is cached, let it know about the changes
+        m_launcher->updateEnvironment();
     }
 
     // Launch autostart applications
+    StartupTrace::begin("autostart");
     autostart();
+    StartupTrace::end("autostart");
 
     m_started = true;
+
+    StartupTrace::end("startup");
+    StartupTrace::save();
 }
 
 void Application::shutdown()
 {
+    StartupTrace::save();
+
+    QCoreApplication::instance()->setProperty(PROCESS_LAUNCHER_PROPERTY, QVariant());
+    m_autostart->deleteLater();
+    m_autostart = nullptr;
+
     m_launcher->deleteLater();
     m_launcher = nullptr;
 
@@ -333,9 +376,18 @@ void Application::autostart()
         //if (!entry.isSuitable(true, QLatin1String("GNOME")) && !entry.isSuitable(true, QLatin1String("KDE")))
         //continue;
 
-        qCDebug(SESSION_MANAGER) << "Autostart:" << entry.name() << "from" << entry.fileName();
-        m_launcher->launchEntry(entry);
+        m_autostart->schedule(entry);
     }
+
+    // Don't compete with the compositor for its first frame
+    QQuickWindow *window = nullptr;
+    const auto windows = QGuiApplication::topLevelWindows();
+    for (QWindow *topLevel : windows) {
+        window = qobject_cast<QQuickWindow *>(topLevel);
+        if (window)
+            break;
+    }
+    m_autostart->startAfterFirstFrame(window);
 }
 
 void Application::unixSignal()
@@ -347,8 +399,10 @@ void Application::unixSignal()
     QCoreApplication::quit();
 }
 
-void Application::objectCreated(QObject *object, const QUrl &)
+void Application::objectCreated(QObject *object, const QUrl &url)
 {
+    StartupTrace::instant(QStringLiteral("Created %1").arg(url.toString()));
+
     // All went fine
     if (object)
         return;
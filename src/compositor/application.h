@@ -32,6 +32,7 @@
 
 QT_FORWARD_DECLARE_CLASS(QQmlApplicationEngine)
 
+class AutostartScheduler;
 class MultimediaKeys;
 class ProcessLauncher;
 class ScreenSaver;
@@ -61,6 +62,7 @@ private:
     QQmlApplicationEngine *m_appEngine;
     MultimediaKeys *m_multimediaKeys;
     ProcessLauncher *m_launcher;
+    AutostartScheduler *m_autostart;
     SessionManager *m_sessionManager;
     bool m_failSafe;
     bool m_started;
@@ -0,0 +1,311 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QQuickWindow>
+
+#include "logging_p.h"
+#include "declarative/framerategovernor.h"
+
+// Frame rates, a negative value means unlimited and 0 means stopped
+#define UNLIMITED_FRAME_RATE -1
+#define STOPPED_FRAME_RATE 0
+
+// Content is barely visible behind the dimmer, 10 fps at 60 Hz
+#define DIMMED_RATE_DIVISOR 6
+
+// Clients asked to save power through the screen saver interface
+#define THROTTLED_RATE_DIVISOR 2
+
+// Used when the output doesn't report a mode, in mHz
+#define DEFAULT_REFRESH_RATE 60000
+
+FrameRateGovernor::FrameRateGovernor(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &FrameRateGovernor::sendFrameCallbacks);
+
+    m_renderTimer.setSingleShot(true);
+    m_renderTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_renderTimer, &QTimer::timeout, this, &FrameRateGovernor::requestUpdate);
+}
+
+QWaylandOutput *FrameRateGovernor::output() const
+{
+    return m_output.data();
+}
+
+void FrameRateGovernor::setOutput(QWaylandOutput *output)
+{
+    if (m_output == output)
+        return;
+
+    if (m_output) {
+        disconnect(m_output.data(), nullptr, this, nullptr);
+        m_output->setAutomaticFrameCallback(true);
+    }
+
+    m_output = output;
+    if (m_output) {
+        connect(m_output.data(), &QWaylandOutput::windowChanged,
+                this, &FrameRateGovernor::updateWindow);
+        connect(m_output.data(), &QWaylandOutput::currentModeChanged,
+                this, &FrameRateGovernor::updateFrameRate);
+        connect(m_output.data(), &QWaylandOutput::currentModeChanged,
+                this, &FrameRateGovernor::updateRenderRate);
+    }
+    Q_EMIT outputChanged();
+
+    updateWindow();
+    m_frameRate = UNLIMITED_FRAME_RATE;
+    updateFrameRate();
+    updateRenderRate();
+}
+
+bool FrameRateGovernor::isDimmed() const
+{
+    return m_dimmed;
+}
+
+void FrameRateGovernor::setDimmed(bool value)
+{
+    if (m_dimmed == value)
+        return;
+
+    m_dimmed = value;
+    Q_EMIT dimmedChanged();
+    updateFrameRate();
+    updateRenderRate();
+}
+
+bool FrameRateGovernor::isPoweredOff() const
+{
+    return m_poweredOff;
+}
+
+void FrameRateGovernor::setPoweredOff(bool value)
+{
+    if (m_poweredOff == value)
+        return;
+
+    m_poweredOff = value;
+    Q_EMIT poweredOffChanged();
+    updateFrameRate();
+    updateRenderRate();
+}
+
+bool FrameRateGovernor::isLocked() const
+{
+    return m_locked;
+}
+
+void FrameRateGovernor::setLocked(bool value)
+{
+    if (m_locked == value)
+        return;
+
+    m_locked = value;
+    Q_EMIT lockedChanged();
+    updateFrameRate();
+}
+
+bool FrameRateGovernor::isThrottled() const
+{
+    return m_throttled;
+}
+
+void FrameRateGovernor::setThrottled(bool value)
+{
+    if (m_throttled == value)
+        return;
+
+    m_throttled = value;
+    Q_EMIT throttledChanged();
+    updateFrameRate();
+    updateRenderRate();
+}
+
+int FrameRateGovernor::frameRate() const
+{
+    return m_frameRate;
+}
+
+int FrameRateGovernor::renderRate() const
+{
+    return m_renderRate;
+}
+
+bool FrameRateGovernor::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != m_window || event->type() != QEvent::UpdateRequest ||
+            m_renderRate == UNLIMITED_FRAME_RATE)
+        return QObject::eventFilter(watched, event);
+
+    // Every render loop polishes, synchronizes and renders the scene
+    // upon update requests: hold them back while nobody can see it
+    if (m_renderRate == STOPPED_FRAME_RATE) {
+        m_updateWithheld = true;
+        return true;
+    }
+
+    // Let the next request through once the interval has passed
+    const qint64 interval = 1000 / m_renderRate;
+    const qint64 elapsed = m_lastRender.isValid() ? m_lastRender.elapsed() : interval;
+    if (elapsed >= interval) {
+        m_lastRender.start();
+        return QObject::eventFilter(watched, event);
+    }
+
+    if (!m_renderTimer.isActive())
+        m_renderTimer.start(int(interval - elapsed));
+    return true;
+}
+
+int FrameRateGovernor::cappedRate(int divisor) const
+{
+    int refreshRate = m_output ? m_output->currentMode().refreshRate() : 0;
+    if (refreshRate <= 0)
+        refreshRate = DEFAULT_REFRESH_RATE;
+    return qMax(1, refreshRate / 1000 / divisor);
+}
+
+void FrameRateGovernor::updateFrameRate()
+{
+    // Clients are not visible when the output is off or
+    // behind the lock screen
+    int frameRate = UNLIMITED_FRAME_RATE;
+    if (m_poweredOff || m_locked)
+        frameRate = STOPPED_FRAME_RATE;
+    else if (m_dimmed)
+        frameRate = cappedRate(DIMMED_RATE_DIVISOR);
+    else if (m_throttled)
+        frameRate = cappedRate(THROTTLED_RATE_DIVISOR);
+
+    if (m_frameRate == frameRate)
+        return;
+
+    const bool wasStopped = m_frameRate == STOPPED_FRAME_RATE;
+    m_frameRate = frameRate;
+    m_timer.stop();
+
+    if (m_output) {
+        qCDebug(lcShell) << "Frame rate of" << m_output->manufacturer() << m_output->model()
+                         << "changed to" << m_frameRate;
+
+        m_output->setAutomaticFrameCallback(m_frameRate == UNLIMITED_FRAME_RATE);
+
+        // Clients waiting for a callback since we stopped would never
+        // commit again, and nothing would be rendered to give them one
+        if (wasStopped && m_frameRate != STOPPED_FRAME_RATE) {
+            sendFrameCallbacks();
+            if (m_window)
+                m_window->update();
+        }
+    }
+
+    Q_EMIT frameRateChanged();
+}
+
+void FrameRateGovernor::updateRenderRate()
+{
+    // The lock screen is rendered, only the clients behind it are stopped
+    int renderRate = UNLIMITED_FRAME_RATE;
+    if (m_poweredOff)
+        renderRate = STOPPED_FRAME_RATE;
+    else if (m_dimmed)
+        renderRate = cappedRate(DIMMED_RATE_DIVISOR);
+    else if (m_throttled)
+        renderRate = cappedRate(THROTTLED_RATE_DIVISOR);
+
+    if (m_renderRate == renderRate)
+        return;
+
+    m_renderRate = renderRate;
+    m_renderTimer.stop();
+
+    // Render what changed while updates were held back
+    if (m_renderRate != STOPPED_FRAME_RATE && m_updateWithheld) {
+        m_updateWithheld = false;
+        requestUpdate();
+    }
+
+    Q_EMIT renderRateChanged();
+}
+
+void FrameRateGovernor::updateWindow()
+{
+    QQuickWindow *window = m_output ? qobject_cast<QQuickWindow *>(m_output->window()) : nullptr;
+    if (m_window == window)
+        return;
+
+    disconnect(m_frameConnection);
+    if (m_window)
+        m_window->removeEventFilter(this);
+    m_window = window;
+    m_updateWithheld = false;
+
+    // Frames are swapped on the render thread
+    if (m_window) {
+        m_window->installEventFilter(this);
+        m_frameConnection = connect(m_window.data(), &QQuickWindow::frameSwapped,
+                                    this, &FrameRateGovernor::handleFrameSwapped,
+                                    Qt::QueuedConnection);
+    }
+}
+
+void FrameRateGovernor::sendFrameCallbacks()
+{
+    if (!m_output)
+        return;
+
+    m_output->sendFrameCallbacks();
+    m_lastCallbacks.start();
+}
+
+void FrameRateGovernor::requestUpdate()
+{
+    // Post the request ourselves: QWindow::requestUpdate() might still
+    // consider the one we held back pending and do nothing
+    if (m_window)
+        QCoreApplication::postEvent(m_window.data(), new QEvent(QEvent::UpdateRequest));
+}
+
+void FrameRateGovernor::handleFrameSwapped()
+{
+    // Automatic frame callbacks are handled by the output
+    if (m_frameRate <= STOPPED_FRAME_RATE || m_timer.isActive())
+        return;
+
+    // Don't send callbacks more often than the frame rate allows
+    const qint64 interval = 1000 / m_frameRate;
+    const qint64 elapsed = m_lastCallbacks.isValid() ? m_lastCallbacks.elapsed() : interval;
+    if (elapsed >= interval)
+        sendFrameCallbacks();
+    else
+        m_timer.start(int(interval - elapsed));
+}
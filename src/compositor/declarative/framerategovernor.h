@@ -0,0 +1,118 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef FRAMERATEGOVERNOR_H
+#define FRAMERATEGOVERNOR_H
+
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QWaylandOutput>
+
+class QQuickWindow;
+
+/*
+ * Decides how often an output is rendered and how often the clients
+ * shown on it get frame callbacks.
+ *
+ * Rendering stops while the output is powered off and is capped while it
+ * is dimmed or throttling was requested, by holding back the update
+ * requests of the window. Caps are fractions of the refresh rate of
+ * the output.
+ * Callbacks follow the same caps and also stop while the session is
+ * locked, the lock screen itself keeps rendering.
+ */
+class FrameRateGovernor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QWaylandOutput *output READ output WRITE setOutput NOTIFY outputChanged)
+    Q_PROPERTY(bool dimmed READ isDimmed WRITE setDimmed NOTIFY dimmedChanged)
+    Q_PROPERTY(bool poweredOff READ isPoweredOff WRITE setPoweredOff NOTIFY poweredOffChanged)
+    Q_PROPERTY(bool locked READ isLocked WRITE setLocked NOTIFY lockedChanged)
+    Q_PROPERTY(bool throttled READ isThrottled WRITE setThrottled NOTIFY throttledChanged)
+    Q_PROPERTY(int frameRate READ frameRate NOTIFY frameRateChanged)
+    Q_PROPERTY(int renderRate READ renderRate NOTIFY renderRateChanged)
+public:
+    explicit FrameRateGovernor(QObject *parent = nullptr);
+
+    QWaylandOutput *output() const;
+    void setOutput(QWaylandOutput *output);
+
+    bool isDimmed() const;
+    void setDimmed(bool value);
+
+    bool isPoweredOff() const;
+    void setPoweredOff(bool value);
+
+    bool isLocked() const;
+    void setLocked(bool value);
+
+    bool isThrottled() const;
+    void setThrottled(bool value);
+
+    int frameRate() const;
+    int renderRate() const;
+
+Q_SIGNALS:
+    void outputChanged();
+    void dimmedChanged();
+    void poweredOffChanged();
+    void lockedChanged();
+    void throttledChanged();
+    void frameRateChanged();
+    void renderRateChanged();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QPointer<QWaylandOutput> m_output;
+    QPointer<QQuickWindow> m_window;
+    QMetaObject::Connection m_frameConnection;
+    bool m_dimmed = false;
+    bool m_poweredOff = false;
+    bool m_locked = false;
+    bool m_throttled = false;
+    int m_frameRate = -1;
+    int m_renderRate = -1;
+    QElapsedTimer m_lastCallbacks;
+    QElapsedTimer m_lastRender;
+    QTimer m_timer;
+    QTimer m_renderTimer;
+    bool m_updateWithheld = false;
+
+    int cappedRate(int divisor) const;
+    void updateFrameRate();
+    void updateRenderRate();
+    void updateWindow();
+    void sendFrameCallbacks();
+    void requestUpdate();
+
+private Q_SLOTS:
+    void handleFrameSwapped();
+};
+
+#endif // FRAMERATEGOVERNOR_H
@@ -0,0 +1,844 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QMetaProperty>
+#include <QRegion>
+#include <QtMath>
+#include <QQmlComponent>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QWaylandBufferRef>
+#include <QWaylandClient>
+#include <QWaylandCompositor>
+#include <QWaylandOutput>
+#include <QWaylandQuickItem>
+#include <QWaylandSurface>
+#include <QWaylandView>
+
+#include "declarative/shellsurfacemodel.h"
+
+static void connectPropertyNotify(QObject *sender, const char *name, QObject *receiver, const char *slot)
+{
+    const QMetaObject *metaObject = sender->metaObject();
+    const int index = metaObject->indexOfProperty(name);
+    if (index < 0)
+        return;
+
+    QMetaProperty property = metaObject->property(index);
+    if (!property.hasNotifySignal())
+        return;
+
+    const int slotIndex = receiver->metaObject()->indexOfSlot(slot);
+    QObject::connect(sender, property.notifySignal(),
+                     receiver, receiver->metaObject()->method(slotIndex));
+}
+
+static QRect innerRect(const QRectF &rect)
+{
+    // Only pixels entirely covered count when looking for occluded windows
+    return QRect(QPoint(qCeil(rect.left()), qCeil(rect.top())),
+                 QPoint(qFloor(rect.right()) - 1, qFloor(rect.bottom()) - 1));
+}
+
+ShellSurfaceModel::ShellSurfaceModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    // Coalesce geometry changes, a move changes x and y separately
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(0);
+    connect(&m_updateTimer, &QTimer::timeout,
+            this, &ShellSurfaceModel::handlePendingUpdates);
+
+    // Occlusion is computed once for a batch of changes
+    m_occlusionTimer.setSingleShot(true);
+    m_occlusionTimer.setInterval(0);
+    connect(&m_occlusionTimer, &QTimer::timeout,
+            this, &ShellSurfaceModel::updateOcclusion);
+    connect(this, &ShellSurfaceModel::stackingOrderChanged,
+            this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(this, &ShellSurfaceModel::maximizedCountChanged,
+            this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(this, &ShellSurfaceModel::fullscreenCountChanged,
+            this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+}
+
+int ShellSurfaceModel::count() const
+{
+    return m_shellSurfaces.size();
+}
+
+int ShellSurfaceModel::maximizedCount() const
+{
+    return m_maximized.size();
+}
+
+int ShellSurfaceModel::fullscreenCount() const
+{
+    return m_fullscreen.size();
+}
+
+QObjectList ShellSurfaceModel::stackingOrder() const
+{
+    return m_stackingOrder.toList();
+}
+
+QVariantList ShellSurfaceModel::processes() const
+{
+    QVariantList list;
+    for (auto it = m_processes.constBegin(); it != m_processes.constEnd(); ++it)
+        list.append(it.key());
+    return list;
+}
+
+QHash<int, QByteArray> ShellSurfaceModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(ShellSurfaceRole, QByteArrayLiteral("shellSurface"));
+    return roles;
+}
+
+int ShellSurfaceModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_shellSurfaces.size();
+}
+
+QVariant ShellSurfaceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_shellSurfaces.size())
+        return QVariant();
+
+    if (role == ShellSurfaceRole)
+        return QVariant::fromValue(m_shellSurfaces.at(index.row()));
+
+    return QVariant();
+}
+
+void ShellSurfaceModel::add(QObject *shellSurface, QQmlComponent *viewComponent)
+{
+    if (!shellSurface || m_surfaces.contains(shellSurface))
+        return;
+
+    QWaylandSurface *surface = shellSurface->property("surface").value<QWaylandSurface *>();
+
+    const int row = m_shellSurfaces.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_shellSurfaces.append(shellSurface);
+    m_stackingOrder.append(shellSurface);
+    m_surfaces.insert(shellSurface, surface);
+    if (surface) {
+        m_bySurface.insert(surface, shellSurface);
+        connect(surface, &QObject::destroyed,
+                this, &ShellSurfaceModel::handleSurfaceDestroyed, Qt::UniqueConnection);
+    }
+    const QString appId = shellSurface->property("canonicalAppId").toString();
+    m_appIds.insert(shellSurface, appId);
+    m_byAppId.insert(appId, shellSurface);
+    const qint64 pid = surface && surface->client() ? surface->client()->processId() : 0;
+    if (pid > 0)
+        m_pids.insert(shellSurface, pid);
+    endInsertRows();
+
+    if (pid > 0 && m_processes[pid]++ == 0)
+        Q_EMIT processesChanged();
+
+    connect(shellSurface, &QObject::destroyed,
+            this, &ShellSurfaceModel::handleShellSurfaceDestroyed);
+    connectPropertyNotify(shellSurface, "canonicalAppId", this, "handleAppIdChanged()");
+    connectPropertyNotify(shellSurface, "maximized", this, "handleMaximizedChanged()");
+    connectPropertyNotify(shellSurface, "fullscreen", this, "handleFullscreenChanged()");
+
+    updateState(shellSurface, "maximized", m_maximized);
+    updateState(shellSurface, "fullscreen", m_fullscreen);
+
+    Q_EMIT countChanged();
+    Q_EMIT stackingOrderChanged();
+
+    if (viewComponent) {
+        m_components.insert(shellSurface, viewComponent);
+
+        QQuickItem *moveItem = shellSurface->property("moveItem").value<QQuickItem *>();
+        if (moveItem) {
+            m_moveItems.insert(shellSurface, moveItem);
+            m_moveItemOwners.insert(moveItem, shellSurface);
+            connect(moveItem, &QQuickItem::xChanged, this, &ShellSurfaceModel::handleGeometryChanged);
+            connect(moveItem, &QQuickItem::yChanged, this, &ShellSurfaceModel::handleGeometryChanged);
+            connect(moveItem, &QQuickItem::widthChanged, this, &ShellSurfaceModel::handleGeometryChanged);
+            connect(moveItem, &QQuickItem::heightChanged, this, &ShellSurfaceModel::handleGeometryChanged);
+        }
+        connectPropertyNotify(shellSurface, "minimized", this, "handleMinimizedChanged()");
+
+        // Views are created right away because the client might map the
+        // surface before we get back to the event loop, and the view is
+        // what places the window when it's mapped
+        updateViews(shellSurface);
+    }
+}
+
+void ShellSurfaceModel::remove(QObject *shellSurface)
+{
+    const int row = m_shellSurfaces.indexOf(shellSurface);
+    if (row < 0)
+        return;
+
+    // Don't touch the object here, it might be halfway destroyed
+    disconnect(shellSurface, nullptr, this, nullptr);
+
+    QQuickItem *moveItem = m_moveItems.take(shellSurface);
+    if (moveItem) {
+        m_moveItemOwners.remove(moveItem);
+        disconnect(moveItem, nullptr, this, nullptr);
+    }
+    m_components.remove(shellSurface);
+    m_pendingUpdates.remove(shellSurface);
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_shellSurfaces.remove(row);
+    m_stackingOrder.removeOne(shellSurface);
+    QWaylandSurface *surface = m_surfaces.take(shellSurface);
+    if (surface && m_bySurface.value(surface) == shellSurface)
+        m_bySurface.remove(surface);
+    m_byAppId.remove(m_appIds.take(shellSurface), shellSurface);
+    const qint64 pid = m_pids.take(shellSurface);
+    endRemoveRows();
+
+    if (pid > 0 && --m_processes[pid] == 0) {
+        m_processes.remove(pid);
+        Q_EMIT processesChanged();
+    }
+
+    if (m_maximized.remove(shellSurface))
+        Q_EMIT maximizedCountChanged();
+    if (m_fullscreen.remove(shellSurface))
+        Q_EMIT fullscreenCountChanged();
+
+    Q_EMIT countChanged();
+    Q_EMIT stackingOrderChanged();
+}
+
+QQmlComponent *ShellSurfaceModel::viewComponent(QObject *shellSurface) const
+{
+    return m_components.value(shellSurface);
+}
+
+void ShellSurfaceModel::addOutput(QWaylandOutput *output)
+{
+    if (!output || m_outputs.contains(output))
+        return;
+
+    m_outputs.append(output);
+    connect(output, &QWaylandOutput::geometryChanged,
+            this, &ShellSurfaceModel::scheduleUpdateAll);
+    connect(output, &QObject::destroyed,
+            this, &ShellSurfaceModel::handleOutputDestroyed, Qt::UniqueConnection);
+
+    scheduleUpdateAll();
+}
+
+void ShellSurfaceModel::removeOutput(QWaylandOutput *output)
+{
+    if (!m_outputs.removeOne(output))
+        return;
+
+    disconnect(output, &QWaylandOutput::geometryChanged,
+               this, &ShellSurfaceModel::scheduleUpdateAll);
+
+    // Views go away with the output window, windows that were only
+    // shown there will get a view on another output
+    handleOutputDestroyed(output);
+    scheduleUpdateAll();
+}
+
+QObject *ShellSurfaceModel::get(int row) const
+{
+    return m_shellSurfaces.value(row, nullptr);
+}
+
+int ShellSurfaceModel::indexOf(QObject *shellSurface) const
+{
+    return m_shellSurfaces.indexOf(shellSurface);
+}
+
+QObject *ShellSurfaceModel::findShellSurface(QWaylandSurface *surface) const
+{
+    return m_bySurface.value(surface, nullptr);
+}
+
+QObjectList ShellSurfaceModel::shellSurfacesForAppId(const QString &appId) const
+{
+    return m_byAppId.values(appId);
+}
+
+bool ShellSurfaceModel::hasProcess(qint64 pid) const
+{
+    return m_processes.contains(pid);
+}
+
+void ShellSurfaceModel::raise(QObject *shellSurface)
+{
+    if (m_stackingOrder.isEmpty() || m_stackingOrder.last() == shellSurface)
+        return;
+
+    const int index = m_stackingOrder.indexOf(shellSurface);
+    if (index < 0)
+        return;
+
+    m_stackingOrder.remove(index);
+    m_stackingOrder.append(shellSurface);
+    Q_EMIT stackingOrderChanged();
+}
+
+void ShellSurfaceModel::setView(QObject *output, QWaylandSurface *surface, QQuickItem *view)
+{
+    if (!output || !surface)
+        return;
+
+    ViewMap &views = m_views[output];
+    if (views.isEmpty())
+        connect(output, &QObject::destroyed,
+                this, &ShellSurfaceModel::handleOutputDestroyed, Qt::UniqueConnection);
+
+    QQuickItem *oldView = views.value(surface, nullptr);
+    if (oldView == view)
+        return;
+    if (oldView)
+        removeView(oldView);
+    if (!view)
+        return;
+
+    // Maps are looked up again because removeView() might have dropped them
+    m_views[output].insert(surface, view);
+    m_viewKeys.insert(view, qMakePair(output, surface));
+    connect(view, &QObject::destroyed,
+            this, &ShellSurfaceModel::handleViewDestroyed, Qt::UniqueConnection);
+    connectPropertyNotify(view, "moving", this, "handleViewMovingChanged()");
+    connect(view, &QQuickItem::xChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(view, &QQuickItem::yChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(view, &QQuickItem::widthChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(view, &QQuickItem::heightChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(view, &QQuickItem::opacityChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(view, &QQuickItem::visibleChanged, this, &ShellSurfaceModel::scheduleOcclusionUpdate);
+    connect(surface, &QObject::destroyed,
+            this, &ShellSurfaceModel::handleSurfaceDestroyed, Qt::UniqueConnection);
+    connect(surface, &QWaylandSurface::redraw,
+            this, &ShellSurfaceModel::handleSurfaceRedraw, Qt::UniqueConnection);
+    scheduleOcclusionUpdate();
+
+    Q_EMIT viewsChanged();
+}
+
+QQuickItem *ShellSurfaceModel::view(QObject *output, QWaylandSurface *surface) const
+{
+    auto it = m_views.constFind(output);
+    if (it == m_views.constEnd())
+        return nullptr;
+    return it->value(surface, nullptr);
+}
+
+QObjectList ShellSurfaceModel::viewsForOutput(QObject *output) const
+{
+    QObjectList list;
+
+    auto it = m_views.constFind(output);
+    if (it == m_views.constEnd())
+        return list;
+
+    // Same order as the model
+    for (QObject *shellSurface : qAsConst(m_shellSurfaces)) {
+        QQuickItem *view = it->value(m_surfaces.value(shellSurface), nullptr);
+        if (view)
+            list.append(view);
+    }
+
+    return list;
+}
+
+QObjectList ShellSurfaceModel::viewsForSurface(QWaylandSurface *surface) const
+{
+    QObjectList list;
+
+    for (auto it = m_views.constBegin(); it != m_views.constEnd(); ++it) {
+        QQuickItem *view = it->value(surface, nullptr);
+        if (view)
+            list.append(view);
+    }
+
+    return list;
+}
+
+bool ShellSurfaceModel::isOutputShowingProcesses(QObject *output, const QVariantList &processes) const
+{
+    if (processes.isEmpty())
+        return false;
+
+    auto it = m_views.constFind(output);
+    if (it == m_views.constEnd())
+        return false;
+
+    QSet<qint64> pids;
+    for (const QVariant &pid : processes)
+        pids.insert(pid.toLongLong());
+
+    for (auto viewIt = it->constBegin(); viewIt != it->constEnd(); ++viewIt) {
+        if (pids.contains(m_pids.value(m_bySurface.value(viewIt.key(), nullptr), 0)))
+            return true;
+    }
+
+    return false;
+}
+
+void ShellSurfaceModel::updateState(QObject *shellSurface, const char *name, QSet<QObject *> &set)
+{
+    const bool value = shellSurface->property(name).toBool();
+    if (value == set.contains(shellSurface))
+        return;
+
+    if (value)
+        set.insert(shellSurface);
+    else
+        set.remove(shellSurface);
+
+    if (&set == &m_maximized)
+        Q_EMIT maximizedCountChanged();
+    else
+        Q_EMIT fullscreenCountChanged();
+}
+
+void ShellSurfaceModel::removeView(QQuickItem *view)
+{
+    auto key = m_viewKeys.take(view);
+    disconnect(view, nullptr, this, nullptr);
+    m_occluded.remove(view);
+    m_opaqueViews.remove(view);
+    scheduleOcclusionUpdate();
+
+    auto it = m_views.find(key.first);
+    if (it == m_views.end())
+        return;
+
+    if (it->value(key.second) == view) {
+        it->remove(key.second);
+        Q_EMIT viewsChanged();
+    }
+}
+
+void ShellSurfaceModel::scheduleUpdate(QObject *shellSurface)
+{
+    if (!shellSurface || !m_components.contains(shellSurface))
+        return;
+
+    m_pendingUpdates.insert(shellSurface);
+    if (!m_updateTimer.isActive())
+        m_updateTimer.start();
+}
+
+void ShellSurfaceModel::scheduleUpdateAll()
+{
+    for (auto it = m_components.constBegin(); it != m_components.constEnd(); ++it)
+        m_pendingUpdates.insert(it.key());
+    if (!m_pendingUpdates.isEmpty() && !m_updateTimer.isActive())
+        m_updateTimer.start();
+}
+
+void ShellSurfaceModel::updateViews(QObject *shellSurface)
+{
+    QWaylandSurface *surface = m_surfaces.value(shellSurface, nullptr);
+    if (!surface || !m_components.value(shellSurface))
+        return;
+
+    // Keep the views while minimizing, the window flies to the launcher
+    if (shellSurface->property("minimized").toBool())
+        return;
+
+    const QSet<QWaylandOutput *> outputs = outputsFor(shellSurface);
+
+    // Copy the list, handlers of these signals add and remove views
+    const QVector<QWaylandOutput *> allOutputs = m_outputs;
+    for (QWaylandOutput *output : allOutputs) {
+        QQuickItem *currentView = view(output, surface);
+
+        if (outputs.contains(output)) {
+            if (!currentView)
+                Q_EMIT viewRequested(shellSurface, output);
+        } else if (currentView && !currentView->property("moving").toBool()) {
+            removeView(currentView);
+            Q_EMIT viewReleased(currentView);
+        }
+    }
+}
+
+QSet<QWaylandOutput *> ShellSurfaceModel::outputsFor(QObject *shellSurface) const
+{
+    QSet<QWaylandOutput *> outputs;
+
+    if (m_outputs.isEmpty())
+        return outputs;
+
+    QQuickItem *moveItem = m_moveItems.value(shellSurface, nullptr);
+    const QRectF rect = moveItem
+            ? QRectF(moveItem->x(), moveItem->y(), moveItem->width(), moveItem->height())
+            : QRectF();
+
+    if (!rect.isEmpty()) {
+        for (QWaylandOutput *output : qAsConst(m_outputs)) {
+            if (rect.intersects(output->geometry()))
+                outputs.insert(output);
+        }
+    }
+
+    if (!outputs.isEmpty())
+        return outputs;
+
+    // The window is not mapped yet or it was moved out of every output:
+    // keep the views it has, otherwise put it where it can be placed
+    QWaylandSurface *surface = m_surfaces.value(shellSurface, nullptr);
+    QWaylandSurface *parentSurface = shellSurface->property("parentWlSurface").value<QWaylandSurface *>();
+    for (QWaylandOutput *output : qAsConst(m_outputs)) {
+        if (view(output, surface) || (parentSurface && view(output, parentSurface)))
+            outputs.insert(output);
+    }
+    if (!outputs.isEmpty())
+        return outputs;
+
+    for (QWaylandOutput *output : qAsConst(m_outputs)) {
+        if (output->geometry().contains(rect.topLeft().toPoint())) {
+            outputs.insert(output);
+            return outputs;
+        }
+    }
+
+    QWaylandOutput *defaultOutput = m_outputs.first()->compositor()->defaultOutput();
+    outputs.insert(m_outputs.contains(defaultOutput) ? defaultOutput : m_outputs.first());
+    return outputs;
+}
+
+bool ShellSurfaceModel::isOpaque(QQuickItem *view) const
+{
+    // The opaque region of surfaces is not available to us, only
+    // buffers without alpha channel are known to cover their area
+    QWaylandView *surfaceView = waylandView(view);
+    if (!surfaceView)
+        return false;
+
+    const QWaylandBufferRef buffer = surfaceView->currentBuffer();
+    if (!buffer.hasContent())
+        return false;
+    if (buffer.isSharedMemory())
+        return !buffer.image().hasAlphaChannel();
+    return buffer.bufferFormatEgl() == QWaylandBufferRef::BufferFormatEgl_RGB;
+}
+
+bool ShellSurfaceModel::isOccluder(QObject *shellSurface, QQuickItem *view) const
+{
+    // Maximized and fullscreen windows are drawn without shadows,
+    // only opaque ones hide what's below unless they are animating
+    if (!m_maximized.contains(shellSurface) && !m_fullscreen.contains(shellSurface))
+        return false;
+    if (shellSurface->property("minimized").toBool())
+        return false;
+    return view->isVisible() && view->opacity() >= 1.0 && m_opaqueViews.contains(view);
+}
+
+void ShellSurfaceModel::setOccluded(QQuickItem *view, bool occluded)
+{
+    if (occluded)
+        m_occluded.insert(view);
+    else
+        m_occluded.remove(view);
+
+    if (view->metaObject()->indexOfProperty("occluded") >= 0)
+        view->setProperty("occluded", occluded);
+
+    // Outputs skip surfaces whose primary view sends its own callbacks,
+    // which we never do for occluded views
+    QWaylandView *surfaceView = waylandView(view);
+    if (surfaceView)
+        surfaceView->setIndependentFrameCallback(occluded);
+}
+
+QWaylandView *ShellSurfaceModel::waylandView(QQuickItem *view) const
+{
+    // Views are chrome items holding the surface item, along with the
+    // chrome of child windows
+    QWaylandSurface *surface = m_viewKeys.value(view).second;
+    if (!surface)
+        return nullptr;
+
+    const auto items = view->findChildren<QWaylandQuickItem *>();
+    for (QWaylandQuickItem *item : items) {
+        if (item->surface() == surface)
+            return item->view();
+    }
+
+    return nullptr;
+}
+
+void ShellSurfaceModel::updatePrimaryView(QWaylandSurface *surface)
+{
+    QWaylandView *primaryView = surface->primaryView();
+    if (!primaryView || !primaryView->independentFrameCallback())
+        return;
+
+    // Windows spanning outputs keep getting callbacks from the outputs
+    // they are still visible on
+    for (auto it = m_views.constBegin(); it != m_views.constEnd(); ++it) {
+        QQuickItem *view = it->value(surface, nullptr);
+        if (!view || m_occluded.contains(view))
+            continue;
+
+        QWaylandView *surfaceView = waylandView(view);
+        if (surfaceView) {
+            surfaceView->setPrimary();
+            return;
+        }
+    }
+}
+
+void ShellSurfaceModel::handleAppIdChanged()
+{
+    QObject *shellSurface = sender();
+    if (!m_appIds.contains(shellSurface))
+        return;
+
+    const QString appId = shellSurface->property("canonicalAppId").toString();
+    const QString oldAppId = m_appIds.value(shellSurface);
+    if (appId == oldAppId)
+        return;
+
+    m_byAppId.remove(oldAppId, shellSurface);
+    m_byAppId.insert(appId, shellSurface);
+    m_appIds.insert(shellSurface, appId);
+}
+
+void ShellSurfaceModel::handleMaximizedChanged()
+{
+    if (m_surfaces.contains(sender()))
+        updateState(sender(), "maximized", m_maximized);
+}
+
+void ShellSurfaceModel::handleFullscreenChanged()
+{
+    if (m_surfaces.contains(sender()))
+        updateState(sender(), "fullscreen", m_fullscreen);
+}
+
+void ShellSurfaceModel::handleShellSurfaceDestroyed(QObject *object)
+{
+    remove(object);
+}
+
+void ShellSurfaceModel::handleSurfaceDestroyed(QObject *object)
+{
+    QWaylandSurface *surface = static_cast<QWaylandSurface *>(object);
+
+    if (m_bySurface.contains(surface)) {
+        QObject *shellSurface = m_bySurface.take(surface);
+        m_surfaces.insert(shellSurface, nullptr);
+    }
+
+    bool viewsRemoved = false;
+    for (auto it = m_views.begin(); it != m_views.end(); ++it) {
+        QQuickItem *view = it->take(surface);
+        if (view) {
+            m_viewKeys.remove(view);
+            m_occluded.remove(view);
+            m_opaqueViews.remove(view);
+            disconnect(view, nullptr, this, nullptr);
+            viewsRemoved = true;
+        }
+    }
+
+    // The window is going away, uncover what's below while it animates
+    scheduleOcclusionUpdate();
+
+    if (viewsRemoved)
+        Q_EMIT viewsChanged();
+}
+
+void ShellSurfaceModel::handleOutputDestroyed(QObject *object)
+{
+    m_outputs.removeOne(static_cast<QWaylandOutput *>(object));
+
+    const ViewMap views = m_views.take(object);
+    for (QQuickItem *view : views) {
+        m_viewKeys.remove(view);
+        m_occluded.remove(view);
+        m_opaqueViews.remove(view);
+        disconnect(view, nullptr, this, nullptr);
+    }
+
+    if (!views.isEmpty())
+        Q_EMIT viewsChanged();
+}
+
+void ShellSurfaceModel::handleViewDestroyed(QObject *object)
+{
+    QQuickItem *view = static_cast<QQuickItem *>(object);
+    if (!m_viewKeys.contains(view))
+        return;
+
+    QWaylandSurface *surface = m_viewKeys.value(view).second;
+    removeView(view);
+
+    // Child windows are destroyed along with the view of their parent,
+    // give them a new one if they are still on that output
+    scheduleUpdate(m_bySurface.value(surface, nullptr));
+}
+
+void ShellSurfaceModel::handleViewMovingChanged()
+{
+    QQuickItem *view = static_cast<QQuickItem *>(sender());
+    if (!view->property("moving").toBool())
+        scheduleUpdate(m_bySurface.value(m_viewKeys.value(view).second, nullptr));
+}
+
+void ShellSurfaceModel::handleGeometryChanged()
+{
+    scheduleUpdate(m_moveItemOwners.value(sender(), nullptr));
+}
+
+void ShellSurfaceModel::handleMinimizedChanged()
+{
+    scheduleUpdate(sender());
+}
+
+void ShellSurfaceModel::handleSurfaceRedraw()
+{
+    QObject *shellSurface = m_bySurface.value(static_cast<QWaylandSurface *>(sender()), nullptr);
+    if (!shellSurface || (!m_maximized.contains(shellSurface) && !m_fullscreen.contains(shellSurface)))
+        return;
+
+    // Views pick up the new buffer when the scene is synchronized,
+    // look at it once the frame showing it has been swapped
+    QWaylandSurface *surface = m_surfaces.value(shellSurface);
+    for (auto it = m_views.constBegin(); it != m_views.constEnd(); ++it) {
+        QQuickItem *view = it->value(surface, nullptr);
+        if (view && view->window()) {
+            connect(view->window(), &QQuickWindow::frameSwapped,
+                    this, &ShellSurfaceModel::handleFrameSwapped, Qt::UniqueConnection);
+            m_bufferCheckPending = true;
+        }
+    }
+}
+
+void ShellSurfaceModel::handleFrameSwapped()
+{
+    if (!m_bufferCheckPending)
+        return;
+    m_bufferCheckPending = false;
+
+    // Clients commit every frame, only a change of buffer format matters
+    for (auto it = m_viewKeys.constBegin(); it != m_viewKeys.constEnd(); ++it) {
+        QObject *shellSurface = m_bySurface.value(it.value().second, nullptr);
+        if (!m_maximized.contains(shellSurface) && !m_fullscreen.contains(shellSurface))
+            continue;
+        if (isOpaque(it.key()) != m_opaqueViews.contains(it.key())) {
+            scheduleOcclusionUpdate();
+            return;
+        }
+    }
+}
+
+void ShellSurfaceModel::handlePendingUpdates()
+{
+    const QSet<QObject *> shellSurfaces = m_pendingUpdates;
+    m_pendingUpdates.clear();
+
+    for (QObject *shellSurface : shellSurfaces) {
+        if (m_surfaces.contains(shellSurface))
+            updateViews(shellSurface);
+    }
+}
+
+void ShellSurfaceModel::scheduleOcclusionUpdate()
+{
+    if (!m_occlusionTimer.isActive())
+        m_occlusionTimer.start();
+}
+
+void ShellSurfaceModel::updateOcclusion()
+{
+    QSet<QQuickItem *> occluded;
+
+    // Buffer formats are only looked at for windows that can occlude
+    m_opaqueViews.clear();
+    for (auto it = m_viewKeys.constBegin(); it != m_viewKeys.constEnd(); ++it) {
+        QObject *shellSurface = m_bySurface.value(it.value().second, nullptr);
+        if (!m_maximized.contains(shellSurface) && !m_fullscreen.contains(shellSurface))
+            continue;
+        if (isOpaque(it.key()))
+            m_opaqueViews.insert(it.key());
+    }
+
+    for (auto it = m_views.constBegin(); it != m_views.constEnd(); ++it) {
+        const ViewMap &views = it.value();
+        QRegion opaqueRegion;
+
+        // Walk top level views from the top of the stack, what they cover
+        // on this output is hidden for all the windows below
+        for (int i = m_stackingOrder.size() - 1; i >= 0; --i) {
+            QObject *shellSurface = m_stackingOrder.at(i);
+            QQuickItem *view = views.value(m_surfaces.value(shellSurface), nullptr);
+            if (!view || m_viewKeys.contains(view->parentItem()))
+                continue;
+
+            const QRectF rect = view->mapRectToScene(QRectF(0, 0, view->width(), view->height()));
+            if (!opaqueRegion.isEmpty() && QRegion(rect.toAlignedRect()).subtracted(opaqueRegion).isEmpty()) {
+                occluded.insert(view);
+                continue;
+            }
+
+            if (isOccluder(shellSurface, view))
+                opaqueRegion += innerRect(rect);
+        }
+    }
+
+    // Child windows are part of the top level window they belong to
+    for (auto it = m_viewKeys.constBegin(); it != m_viewKeys.constEnd(); ++it) {
+        QQuickItem *topLevel = it.key();
+        for (QQuickItem *item = topLevel->parentItem(); item; item = item->parentItem()) {
+            if (m_viewKeys.contains(item))
+                topLevel = item;
+        }
+        if (topLevel != it.key() && occluded.contains(topLevel))
+            occluded.insert(it.key());
+    }
+
+    const QSet<QQuickItem *> uncovered = m_occluded - occluded;
+    for (QQuickItem *view : uncovered)
+        setOccluded(view, false);
+
+    // Surfaces of occluded views might have got a visible view meanwhile
+    QSet<QWaylandSurface *> surfaces;
+    for (QQuickItem *view : qAsConst(occluded)) {
+        if (!m_occluded.contains(view))
+            setOccluded(view, true);
+        surfaces.insert(m_viewKeys.value(view).second);
+    }
+    for (QWaylandSurface *surface : qAsConst(surfaces)) {
+        if (surface)
+            updatePrimaryView(surface);
+    }
+}
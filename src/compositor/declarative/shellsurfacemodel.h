@@ -0,0 +1,185 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef SHELLSURFACEMODEL_H
+#define SHELLSURFACEMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+class QQmlComponent;
+class QQuickItem;
+class QWaylandOutput;
+class QWaylandSurface;
+class QWaylandView;
+
+/*
+ * Registry of the shell surfaces of the compositor.
+ *
+ * Rows are in creation order, lookups by surface, application and output
+ * are hashed. It also keeps the views created for each shell surface on
+ * every output, dropping them when the view, the surface or the output
+ * goes away, and counts maximized and fullscreen shell surfaces by
+ * following their properties.
+ *
+ * Shell surfaces added with a view component only get views on the
+ * outputs their move item intersects: viewRequested() and viewReleased()
+ * are emitted as the window moves across outputs, views being dragged
+ * are kept until the move ends and minimized windows keep the views
+ * they had.
+ *
+ * Views entirely covered by maximized or fullscreen windows above them
+ * on the same output get their "occluded" property set, as long as the
+ * windows above have a buffer without alpha channel: we can't tell
+ * which parts of a translucent buffer are opaque. Child windows
+ * follow their top level window. Occluded views stay on their output but
+ * don't get frame callbacks from it, and the primary view of a surface
+ * moves to one that is still visible when there is any.
+ *
+ * Shell surfaces are also counted by client process, to tell which
+ * processes have windows and on which outputs they are shown.
+ */
+class ShellSurfaceModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int maximizedCount READ maximizedCount NOTIFY maximizedCountChanged)
+    Q_PROPERTY(int fullscreenCount READ fullscreenCount NOTIFY fullscreenCountChanged)
+    Q_PROPERTY(QObjectList stackingOrder READ stackingOrder NOTIFY stackingOrderChanged)
+    Q_PROPERTY(QVariantList processes READ processes NOTIFY processesChanged)
+public:
+    enum Role {
+        ShellSurfaceRole = Qt::UserRole + 1
+    };
+
+    explicit ShellSurfaceModel(QObject *parent = nullptr);
+
+    int count() const;
+    int maximizedCount() const;
+    int fullscreenCount() const;
+
+    QObjectList stackingOrder() const;
+
+    QVariantList processes() const;
+
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    Q_INVOKABLE void add(QObject *shellSurface, QQmlComponent *viewComponent = nullptr);
+    Q_INVOKABLE void remove(QObject *shellSurface);
+
+    Q_INVOKABLE QQmlComponent *viewComponent(QObject *shellSurface) const;
+
+    Q_INVOKABLE void addOutput(QWaylandOutput *output);
+    Q_INVOKABLE void removeOutput(QWaylandOutput *output);
+
+    Q_INVOKABLE QObject *get(int row) const;
+    Q_INVOKABLE int indexOf(QObject *shellSurface) const;
+
+    Q_INVOKABLE QObject *findShellSurface(QWaylandSurface *surface) const;
+    Q_INVOKABLE QObjectList shellSurfacesForAppId(const QString &appId) const;
+    Q_INVOKABLE bool hasProcess(qint64 pid) const;
+
+    Q_INVOKABLE void raise(QObject *shellSurface);
+
+    Q_INVOKABLE void setView(QObject *output, QWaylandSurface *surface, QQuickItem *view);
+    Q_INVOKABLE QQuickItem *view(QObject *output, QWaylandSurface *surface) const;
+    Q_INVOKABLE QObjectList viewsForOutput(QObject *output) const;
+    Q_INVOKABLE QObjectList viewsForSurface(QWaylandSurface *surface) const;
+    Q_INVOKABLE bool isOutputShowingProcesses(QObject *output, const QVariantList &processes) const;
+
+Q_SIGNALS:
+    void countChanged();
+    void maximizedCountChanged();
+    void fullscreenCountChanged();
+    void stackingOrderChanged();
+    void processesChanged();
+    void viewsChanged();
+    void viewRequested(QObject *shellSurface, QWaylandOutput *output);
+    void viewReleased(QQuickItem *view);
+
+private:
+    typedef QHash<QWaylandSurface *, QQuickItem *> ViewMap;
+
+    QVector<QObject *> m_shellSurfaces;
+    QVector<QObject *> m_stackingOrder;
+    QHash<QObject *, QWaylandSurface *> m_surfaces;
+    QHash<QWaylandSurface *, QObject *> m_bySurface;
+    QHash<QObject *, QString> m_appIds;
+    QMultiHash<QString, QObject *> m_byAppId;
+    QHash<QObject *, qint64> m_pids;
+    QHash<qint64, int> m_processes;
+    QSet<QObject *> m_maximized;
+    QSet<QObject *> m_fullscreen;
+    QHash<QObject *, ViewMap> m_views;
+    QHash<QQuickItem *, QPair<QObject *, QWaylandSurface *>> m_viewKeys;
+    QVector<QWaylandOutput *> m_outputs;
+    QHash<QObject *, QPointer<QQmlComponent>> m_components;
+    QHash<QObject *, QQuickItem *> m_moveItems;
+    QHash<QObject *, QObject *> m_moveItemOwners;
+    QSet<QObject *> m_pendingUpdates;
+    QTimer m_updateTimer;
+    QSet<QQuickItem *> m_occluded;
+    QSet<QQuickItem *> m_opaqueViews;
+    bool m_bufferCheckPending = false;
+    QTimer m_occlusionTimer;
+
+    void updateState(QObject *shellSurface, const char *name, QSet<QObject *> &set);
+    void removeView(QQuickItem *view);
+    void scheduleUpdate(QObject *shellSurface);
+    void scheduleUpdateAll();
+    void updateViews(QObject *shellSurface);
+    QSet<QWaylandOutput *> outputsFor(QObject *shellSurface) const;
+    bool isOpaque(QQuickItem *view) const;
+    bool isOccluder(QObject *shellSurface, QQuickItem *view) const;
+    void setOccluded(QQuickItem *view, bool occluded);
+    QWaylandView *waylandView(QQuickItem *view) const;
+    void updatePrimaryView(QWaylandSurface *surface);
+
+private Q_SLOTS:
+    void handleAppIdChanged();
+    void handleMaximizedChanged();
+    void handleFullscreenChanged();
+    void handleShellSurfaceDestroyed(QObject *object);
+    void handleSurfaceDestroyed(QObject *object);
+    void handleOutputDestroyed(QObject *object);
+    void handleViewDestroyed(QObject *object);
+    void handleViewMovingChanged();
+    void handleGeometryChanged();
+    void handleMinimizedChanged();
+    void handleSurfaceRedraw();
+    void handleFrameSwapped();
+    void handlePendingUpdates();
+    void scheduleOcclusionUpdate();
+    void updateOcclusion();
+};
+
+#endif // SHELLSURFACEMODEL_H
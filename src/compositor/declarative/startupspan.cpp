@@ -0,0 +1,58 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+
+#include "startupspan.h"
+#include "startuptrace.h"
+
+StartupSpan::StartupSpan(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString StartupSpan::name() const
+{
+    return m_name;
+}
+
+void StartupSpan::setName(const QString &name)
+{
+    if (m_name == name)
+        return;
+
+    m_name = name;
+    Q_EMIT nameChanged();
+}
+
+void StartupSpan::classBegin()
+{
+    m_begin = StartupTrace::timestamp();
+}
+
+void StartupSpan::componentComplete()
+{
+    StartupTrace::complete(m_name, m_begin);
+}
@@ -0,0 +1,63 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+
+#ifndef STARTUPSPAN_H
+#define STARTUPSPAN_H
+
+#include <QObject>
+#include <QQmlParserStatus>
+
+/*
+ * Traces the creation of the QML component it's declared in.
+ *
+ * The span begins when this object is created and ends when the whole
+ * component is complete, declare it first for the span to cover
+ * the other objects.
+ */
+class StartupSpan : public QObject, public QQmlParserStatus
+{
+    Q_OBJECT
+    Q_INTERFACES(QQmlParserStatus)
+    Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged)
+public:
+    explicit StartupSpan(QObject *parent = nullptr);
+
+    QString name() const;
+    void setName(const QString &name);
+
+    void classBegin() override;
+    void componentComplete() override;
+
+Q_SIGNALS:
+    void nameChanged();
+
+private:
+    QString m_name;
+    qint64 m_begin = -1;
+};
+
+#endif // STARTUPSPAN_H
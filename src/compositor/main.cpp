@@ -35,6 +35,7 @@
 
 #include "gitsha1.h"
 #include "application.h"
+#include "startuptrace.h"
 
 #if HAVE_SYS_PRCTL_H
 #include <sys/prctl.h>
@@ -138,6 +139,12 @@ int main(int argc, char *argv[])
                                              TR("Raise SIGSTOP on startup"));
     parser.addOption(waitForDebuggerOption);
 
+    // Record the startup sequence
+    QCommandLineOption startupTraceOption(QStringLiteral("startup-trace"),
+                                          TR("Write a trace of the startup sequence in the Chrome trace event format"),
+                                          TR("filename"));
+    parser.addOption(startupTraceOption);
+
 #ifdef DEVELOPMENT_BUILD
     // Load shell from an arbitrary path
     QCommandLineOption qmlOption(QStringLiteral("qml"),
@@ -158,6 +165,10 @@ int main(int argc, char *argv[])
     // Arguments
     QString fakeScreenData = parser.value(fakeScreenOption);
 
+    // Start tracing as early as possible
+    if (parser.isSet(startupTraceOption))
+        StartupTrace::setFileName(parser.value(startupTraceOption));
+
     // Wait for debugger
     if (parser.isSet(waitForDebuggerOption)) {
         qWarning("Waiting for debugger on PID %lld, send SIGCONT to continue...",
@@ -176,7 +187,9 @@ int main(int argc, char *argv[])
     qInfo("%s", qPrintable(Application::systemInformation().trimmed()));
 
     // Application
+    StartupTrace::begin("Application::Application");
     Application *shell = new Application();
+    StartupTrace::end("Application::Application");
     shell->setAutostartEnabled(!parser.isSet(noAutostartOption));
     shell->setScreenConfigurationFileName(fakeScreenData);
 
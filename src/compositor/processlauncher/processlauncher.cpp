@@ -25,6 +25,7 @@
  ***************************************************************************/
 
 #include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusError>
 
@@ -32,17 +33,79 @@
 
 #include "processlauncher.h"
 #include "processlauncher_adaptor.h"
+#include "processspawner.h"
 
 Q_LOGGING_CATEGORY(LAUNCHER, "liri.launcher")
 
+// Time applications have to quit, all together, before being killed;
+// closing doesn't block anything, this only bounds how long a client
+// that ignores SIGTERM keeps its windows around
+#define TERMINATE_TIMEOUT_MS (5 * 1000)
+
+// Time to wait for killed applications
+#define KILL_TIMEOUT_MS 1000
+
+static QStringList splitCommand(const QString &command)
+{
+    QStringList args;
+    QString arg;
+    int quoteCount = 0;
+    bool inQuote = false;
+
+    // Same rules as QProcess::start(): tokens are separated by spaces,
+    // double quotes group them and three consecutive quotes make a literal one
+    for (int i = 0; i < command.size(); ++i) {
+        if (command.at(i) == QLatin1Char('"')) {
+            ++quoteCount;
+            if (quoteCount == 3) {
+                quoteCount = 0;
+                arg += command.at(i);
+            }
+            continue;
+        }
+        if (quoteCount) {
+            if (quoteCount == 1)
+                inQuote = !inQuote;
+            quoteCount = 0;
+        }
+        if (!inQuote && command.at(i).isSpace()) {
+            if (!arg.isEmpty()) {
+                args.append(arg);
+                arg.clear();
+            }
+        } else {
+            arg += command.at(i);
+        }
+    }
+    if (!arg.isEmpty())
+        args.append(arg);
+
+    return args;
+}
+
 ProcessLauncher::ProcessLauncher(QObject *parent)
     : QObject(parent)
+    , m_spawner(new ProcessSpawner(this))
 {
+    m_spawner->setEnvironmentVariable("SAL_USE_VCLPLUGIN", "kde");
+    m_spawner->setEnvironmentVariable("QT_PLATFORM_PLUGIN", "liri");
+    m_spawner->unsetEnvironmentVariable("QSG_RENDER_LOOP");
+    m_spawner->unsetEnvironmentVariable("EGL_PLATFORM");
+
+    connect(m_spawner, &ProcessSpawner::finished,
+            this, &ProcessLauncher::finished);
 }
 
 ProcessLauncher::~ProcessLauncher()
 {
     closeApplications();
+
+    // There is no event loop left to finish closing from, wait here instead
+    if (!m_closingApps.isEmpty()) {
+        const QList<qint64> running = m_spawner->waitForFinished(m_closingApps.keys(), TERMINATE_TIMEOUT_MS);
+        const QList<qint64> killed = killStragglers(running);
+        forgetSurvivors(m_spawner->waitForFinished(killed, KILL_TIMEOUT_MS));
+    }
 }
 
 QString ProcessLauncher::waylandSocketName() const
@@ -56,31 +119,27 @@ void ProcessLauncher::setWaylandSocketName(const QString &name)
         return;
 
     m_waylandSocketName = name;
+    if (m_waylandSocketName.isEmpty())
+        m_spawner->unsetEnvironmentVariable("WAYLAND_DISPLAY");
+    else
+        m_spawner->setEnvironmentVariable("WAYLAND_DISPLAY", m_waylandSocketName.toLocal8Bit());
     Q_EMIT waylandSocketNameChanged();
 }
 
+void ProcessLauncher::updateEnvironment()
+{
+    // Pick up changes to the compositor environment with the next launch
+    m_spawner->invalidateEnvironment();
+}
+
 void ProcessLauncher::closeApplications()
 {
     qCDebug(LAUNCHER) << "Terminate applications";
 
     // Terminate all process launched by us
-    ApplicationMapIterator i(m_apps);
-    while (i.hasNext()) {
-        i.next();
-
-        QString fileName = i.key();
-        QProcess *process = i.value();
-
-        i.remove();
-
-        qCDebug(LAUNCHER) << "Terminating application from" << fileName << "with pid"
-                          << process->pid();
-
-        process->terminate();
-        if (!process->waitForFinished())
-            process->kill();
-        process->deleteLater();
-    }
+    ApplicationMap apps;
+    apps.swap(m_apps);
+    terminate(apps);
 }
 
 bool ProcessLauncher::registerWithDBus(ProcessLauncher *instance)
@@ -145,27 +204,20 @@ bool ProcessLauncher::launchCommand(const QString &command)
 
     qCInfo(LAUNCHER) << "Launching command" << command;
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!m_waylandSocketName.isEmpty())
-        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_waylandSocketName);
-    env.insert(QStringLiteral("SAL_USE_VCLPLUGIN"), QStringLiteral("kde"));
-    env.insert(QStringLiteral("QT_PLATFORM_PLUGIN"), QStringLiteral("liri"));
-    env.remove(QStringLiteral("QSG_RENDER_LOOP"));
-    env.remove(QStringLiteral("EGL_PLATFORM"));
-
-    QProcess *process = new QProcess(this);
-    process->setProcessEnvironment(env);
-    process->setProcessChannelMode(QProcess::ForwardedChannels);
-    connect(process,
-            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
-            &ProcessLauncher::finished);
-    process->start(command);
-    if (!process->waitForStarted()) {
+    QStringList args = splitCommand(command);
+    if (args.isEmpty()) {
         qCWarning(LAUNCHER) << "Failed to launch command" << command;
         return false;
     }
 
-    qCInfo(LAUNCHER) << "Launched command" << command << "with pid" << process->pid();
+    const QString program = args.takeFirst();
+    qint64 pid = m_spawner->spawn(program, args);
+    if (pid <= 0) {
+        qCWarning(LAUNCHER) << "Failed to launch command" << command;
+        return false;
+    }
+
+    qCInfo(LAUNCHER) << "Launched command" << command << "with pid" << pid;
 
     return true;
 }
@@ -184,37 +236,27 @@ bool ProcessLauncher::closeDesktopFile(const QString &fileName)
 bool ProcessLauncher::launchEntry(const XdgDesktopFile &entry)
 {
     QStringList args = entry.expandExecString();
-    QString command = args.takeAt(0);
+    if (args.isEmpty()) {
+        qCWarning(LAUNCHER, "Empty Exec key in \"%s\"", qPrintable(entry.fileName()));
+        return false;
+    }
 
-    qCDebug(LAUNCHER) << "Launching" << entry.expandExecString().join(QStringLiteral(" ")) << "from"
+    qCDebug(LAUNCHER) << "Launching" << args.join(QStringLiteral(" ")) << "from"
                       << entry.fileName();
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!m_waylandSocketName.isEmpty())
-        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_waylandSocketName);
-    env.insert(QStringLiteral("SAL_USE_VCLPLUGIN"), QStringLiteral("kde"));
-    env.insert(QStringLiteral("QT_PLATFORM_PLUGIN"), QStringLiteral("liri"));
-    env.remove(QStringLiteral("QSG_RENDER_LOOP"));
-    env.remove(QStringLiteral("EGL_PLATFORM"));
-
-    QProcess *process = new QProcess(this);
-    process->setProgram(command);
-    process->setArguments(args);
-    process->setProcessEnvironment(env);
-    process->setProcessChannelMode(QProcess::ForwardedChannels);
-    m_apps[entry.fileName()] = process;
-    connect(process,
-            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this,
-            &ProcessLauncher::finished);
-    process->start();
-    if (!process->waitForStarted()) {
+    QString command = args.takeAt(0);
+
+    qint64 pid = m_spawner->spawn(command, args);
+    if (pid <= 0) {
         qCWarning(LAUNCHER, "Failed to launch \"%s\" (%s)", qPrintable(entry.fileName()),
                   qPrintable(entry.name()));
         return false;
     }
 
+    m_apps[entry.fileName()] = pid;
+
     qCDebug(LAUNCHER, "Launched \"%s\" (%s) with pid %lld", qPrintable(entry.fileName()),
-            qPrintable(entry.name()), process->pid());
+            qPrintable(entry.name()), pid);
 
     return true;
 }
@@ -226,28 +268,92 @@ bool ProcessLauncher::closeEntry(const QString &fileName)
 
     qCInfo(LAUNCHER) << "Closing application for" << fileName;
 
-    QProcess *process = m_apps[fileName];
-    process->terminate();
-    if (!process->waitForFinished())
-        process->kill();
+    ApplicationMap apps;
+    apps.insert(fileName, m_apps.take(fileName));
+    terminate(apps);
     return true;
 }
 
-void ProcessLauncher::finished(int exitCode, QProcess::ExitStatus exitStatus)
+void ProcessLauncher::terminate(const ApplicationMap &apps)
 {
-    Q_UNUSED(exitStatus);
+    if (apps.isEmpty())
+        return;
+
+    // Ask everybody to quit at once, so that we only wait
+    // as long as the slowest application
+    const QList<qint64> pids = apps.values();
+    for (auto it = apps.constBegin(); it != apps.constEnd(); ++it) {
+        qCDebug(LAUNCHER) << "Terminating application from" << it.key() << "with pid" << it.value();
+
+        ClosingApplication &app = m_closingApps[it.value()];
+        app.fileName = it.key();
+        app.timer.start();
+        m_spawner->terminate(it.value());
+    }
+
+    // Exits are picked up by the spawner from the pidfds,
+    // whoever is still around at the deadline is killed
+    QTimer::singleShot(TERMINATE_TIMEOUT_MS, this, [this, pids] {
+        const QList<qint64> killed = killStragglers(pids);
+        if (killed.isEmpty())
+            return;
+
+        QTimer::singleShot(KILL_TIMEOUT_MS, this, [this, killed] {
+            forgetSurvivors(killed);
+        });
+    });
+}
+
+QList<qint64> ProcessLauncher::killStragglers(const QList<qint64> &pids)
+{
+    QList<qint64> killed;
+
+    for (qint64 pid : pids) {
+        if (!m_closingApps.contains(pid))
+            continue;
+
+        qCWarning(LAUNCHER) << "Application from" << m_closingApps.value(pid).fileName
+                            << "with pid" << pid << "didn't quit in"
+                            << TERMINATE_TIMEOUT_MS << "ms, killing it";
+        m_spawner->kill(pid);
+        killed.append(pid);
+    }
 
-    QProcess *process = qobject_cast<QProcess *>(sender());
-    if (!process)
+    return killed;
+}
+
+void ProcessLauncher::forgetSurvivors(const QList<qint64> &pids)
+{
+    for (qint64 pid : pids) {
+        if (!m_closingApps.contains(pid))
+            continue;
+
+        qCWarning(LAUNCHER) << "Application from" << m_closingApps.take(pid).fileName
+                            << "with pid" << pid << "survived SIGKILL";
+    }
+}
+
+void ProcessLauncher::finished(qint64 pid, int exitCode, bool crashed)
+{
+    // Exit latency for applications we are closing
+    if (m_closingApps.contains(pid)) {
+        const ClosingApplication app = m_closingApps.take(pid);
+        qCInfo(LAUNCHER) << "Application for" << app.fileName << "exited after"
+                         << app.timer.elapsed() << "ms";
+        return;
+    }
+
+    QString fileName = m_apps.key(pid);
+    if (fileName.isEmpty())
         return;
 
-    QString fileName = m_apps.key(process);
-    if (!fileName.isEmpty()) {
+    if (crashed)
+        qCDebug(LAUNCHER) << "Application for" << fileName << "crashed";
+    else
         qCDebug(LAUNCHER) << "Application for" << fileName << "finished with exit code" << exitCode;
-        m_apps.remove(fileName);
-    }
+    m_apps.remove(fileName);
 
-    process->deleteLater();
+    Q_EMIT applicationFinished(fileName);
 }
 
 #include "moc_processlauncher.cpp"
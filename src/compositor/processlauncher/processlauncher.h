@@ -27,18 +27,19 @@
 #ifndef PROCESSLAUNCHER_H
 #define PROCESSLAUNCHER_H
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMap>
 #include <QtCore/QObject>
-#include <QtCore/QProcess>
 
 Q_DECLARE_LOGGING_CATEGORY(LAUNCHER)
 
-class QProcess;
+class ProcessSpawner;
 class XdgDesktopFile;
 
-typedef QMap<QString, QProcess *> ApplicationMap;
-typedef QMutableMapIterator<QString, QProcess *> ApplicationMapIterator;
+typedef QMap<QString, qint64> ApplicationMap;
+typedef QMutableMapIterator<QString, qint64> ApplicationMapIterator;
 
 class ProcessLauncher : public QObject
 {
@@ -52,6 +53,8 @@ public:
     QString waylandSocketName() const;
     void setWaylandSocketName(const QString &name);
 
+    void updateEnvironment();
+
     Q_INVOKABLE bool launchApplication(const QString &appId);
     Q_INVOKABLE bool launchDesktopFile(const QString &fileName);
     Q_INVOKABLE bool launchCommand(const QString &command);
@@ -65,15 +68,27 @@ public:
 
 Q_SIGNALS:
     void waylandSocketNameChanged();
+    void applicationFinished(const QString &fileName);
 
 private:
     QString m_waylandSocketName;
+    ProcessSpawner *m_spawner;
     ApplicationMap m_apps;
 
+    struct ClosingApplication
+    {
+        QString fileName;
+        QElapsedTimer timer;
+    };
+    QHash<qint64, ClosingApplication> m_closingApps;
+
     bool closeEntry(const QString &fileName);
+    void terminate(const ApplicationMap &apps);
+    QList<qint64> killStragglers(const QList<qint64> &pids);
+    void forgetSurvivors(const QList<qint64> &pids);
 
 private Q_SLOTS:
-    void finished(int exitCode, QProcess::ExitStatus exitStatus);
+    void finished(qint64 pid, int exitCode, bool crashed);
 };
 
 #endif // PROCESSLAUNCHER_H
@@ -0,0 +1,354 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QFile>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+
+#include "processlauncher.h"
+#include "processspawner.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+// How often children are polled when pidfds are not available
+#define POLL_INTERVAL_MS 1000
+
+// How often children without pidfd are checked while waiting for them
+#define WAIT_POLL_INTERVAL_MS 10
+
+// Maximum number of events read at once from the epoll descriptor
+#define MAX_EVENTS 16
+
+static int pidfdOpen(pid_t pid)
+{
+#if defined(SYS_pidfd_open)
+    return int(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+ProcessSpawner::ProcessSpawner(QObject *parent)
+    : QObject(parent)
+    , m_pollTimer(new QTimer(this))
+{
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd >= 0) {
+        m_notifier = new QSocketNotifier(m_epollFd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &ProcessSpawner::pidfdActivated);
+    } else {
+        qCWarning(LAUNCHER, "Failed to create epoll descriptor: %s", strerror(errno));
+    }
+
+    // Fallback for kernels without pidfd support
+    m_pollTimer->setInterval(POLL_INTERVAL_MS);
+    connect(m_pollTimer, &QTimer::timeout, this, &ProcessSpawner::pollChildren);
+}
+
+ProcessSpawner::~ProcessSpawner()
+{
+    for (int pidfd : qAsConst(m_children)) {
+        if (pidfd >= 0)
+            ::close(pidfd);
+    }
+
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+void ProcessSpawner::setEnvironmentVariable(const QByteArray &name, const QByteArray &value)
+{
+    // Null values mean unset, make sure an empty value is kept
+    const QByteArray newValue = value.isNull() ? QByteArray("") : value;
+
+    auto it = m_overrides.constFind(name);
+    if (it != m_overrides.constEnd() && !it.value().isNull() && it.value() == newValue)
+        return;
+
+    m_overrides.insert(name, newValue);
+    m_environmentValid = false;
+}
+
+void ProcessSpawner::unsetEnvironmentVariable(const QByteArray &name)
+{
+    auto it = m_overrides.constFind(name);
+    if (it != m_overrides.constEnd() && it.value().isNull())
+        return;
+
+    m_overrides.insert(name, QByteArray());
+    m_environmentValid = false;
+}
+
+void ProcessSpawner::invalidateEnvironment()
+{
+    m_environmentValid = false;
+}
+
+qint64 ProcessSpawner::spawn(const QString &program, const QStringList &arguments)
+{
+    if (!m_environmentValid)
+        rebuildEnvironment();
+
+    QVector<QByteArray> args;
+    args.reserve(arguments.size() + 1);
+    args.append(QFile::encodeName(program));
+    for (const QString &argument : arguments)
+        args.append(QFile::encodeName(argument));
+
+    QVector<char *> argv;
+    argv.reserve(args.size() + 1);
+    for (QByteArray &arg : args)
+        argv.append(arg.data());
+    argv.append(nullptr);
+
+    // Children start with a clean signal state, the compositor
+    // ignores or handles a few of them
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGHUP);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGTERM);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#if defined(POSIX_SPAWN_USEVFORK)
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    pid_t pid = 0;
+    int error = ::posix_spawnp(&pid, argv.at(0), nullptr, &attr,
+                               argv.data(), m_envp.data());
+    posix_spawnattr_destroy(&attr);
+
+    if (error != 0) {
+        qCWarning(LAUNCHER, "Failed to spawn \"%s\": %s",
+                  qPrintable(program), strerror(error));
+        return -1;
+    }
+
+    int pidfd = pidfdOpen(pid);
+    if (pidfd >= 0 && m_epollFd >= 0) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = quint64(pid);
+        if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, pidfd, &event) < 0) {
+            ::close(pidfd);
+            pidfd = -1;
+        }
+    } else if (pidfd >= 0) {
+        ::close(pidfd);
+        pidfd = -1;
+    }
+
+    m_children.insert(pid, pidfd);
+    if (pidfd < 0 && !m_pollTimer->isActive())
+        m_pollTimer->start();
+
+    return pid;
+}
+
+bool ProcessSpawner::isRunning(qint64 pid) const
+{
+    return m_children.contains(pid);
+}
+
+bool ProcessSpawner::terminate(qint64 pid)
+{
+    if (!m_children.contains(pid))
+        return false;
+    return ::kill(pid_t(pid), SIGTERM) == 0;
+}
+
+bool ProcessSpawner::kill(qint64 pid)
+{
+    if (!m_children.contains(pid))
+        return false;
+    return ::kill(pid_t(pid), SIGKILL) == 0;
+}
+
+QList<qint64> ProcessSpawner::waitForFinished(const QList<qint64> &pids, int msecs)
+{
+    QDeadlineTimer deadline(msecs);
+
+    QList<qint64> running;
+    for (qint64 pid : pids) {
+        if (m_children.contains(pid) && !reap(pid))
+            running.append(pid);
+    }
+
+    while (!running.isEmpty()) {
+        // Wait for all pidfds at once, children without one are
+        // checked again every few milliseconds
+        QVector<struct pollfd> fds;
+        bool polling = false;
+        for (qint64 pid : qAsConst(running)) {
+            const int pidfd = m_children.value(pid, -1);
+            if (pidfd < 0) {
+                polling = true;
+                continue;
+            }
+
+            struct pollfd pfd;
+            pfd.fd = pidfd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            fds.append(pfd);
+        }
+
+        int timeout = int(deadline.remainingTime());
+        if (polling)
+            timeout = qMin(timeout, WAIT_POLL_INTERVAL_MS);
+
+        int ret = ::poll(fds.data(), nfds_t(fds.size()), timeout);
+        if (ret < 0 && errno != EINTR)
+            break;
+
+        QMutableListIterator<qint64> it(running);
+        while (it.hasNext()) {
+            if (reap(it.next()))
+                it.remove();
+        }
+
+        if (deadline.hasExpired())
+            break;
+    }
+
+    return running;
+}
+
+void ProcessSpawner::rebuildEnvironment()
+{
+    m_environment.clear();
+    m_envp.clear();
+
+    for (char **var = environ; var && *var; ++var) {
+        const QByteArray entry(*var);
+        const int index = entry.indexOf('=');
+        if (index > 0 && m_overrides.contains(entry.left(index)))
+            continue;
+        m_environment.append(entry);
+    }
+
+    for (auto it = m_overrides.constBegin(); it != m_overrides.constEnd(); ++it) {
+        if (!it.value().isNull())
+            m_environment.append(it.key() + '=' + it.value());
+    }
+
+    m_envp.reserve(m_environment.size() + 1);
+    for (QByteArray &entry : m_environment)
+        m_envp.append(entry.data());
+    m_envp.append(nullptr);
+
+    m_environmentValid = true;
+}
+
+bool ProcessSpawner::reap(qint64 pid)
+{
+    int status = 0;
+    pid_t ret;
+    do {
+        ret = ::waitpid(pid_t(pid), &status, WNOHANG);
+    } while (ret < 0 && errno == EINTR);
+
+    // Still running
+    if (ret == 0)
+        return false;
+
+    const int pidfd = m_children.take(pid);
+    if (pidfd >= 0) {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, pidfd, nullptr);
+        ::close(pidfd);
+    }
+
+    int exitCode = -1;
+    bool crashed = false;
+    if (ret > 0) {
+        if (WIFEXITED(status))
+            exitCode = WEXITSTATUS(status);
+        else if (WIFSIGNALED(status))
+            crashed = true;
+    }
+
+    Q_EMIT finished(pid, exitCode, crashed);
+
+    return true;
+}
+
+void ProcessSpawner::pidfdActivated()
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    int count;
+    do {
+        count = ::epoll_wait(m_epollFd, events, MAX_EVENTS, 0);
+    } while (count < 0 && errno == EINTR);
+
+    for (int i = 0; i < count; ++i)
+        reap(qint64(events[i].data.u64));
+}
+
+void ProcessSpawner::pollChildren()
+{
+    bool polling = false;
+
+    const QList<qint64> pids = m_children.keys();
+    for (qint64 pid : pids) {
+        if (m_children.value(pid, 0) >= 0)
+            continue;
+        if (!reap(pid))
+            polling = true;
+    }
+
+    if (!polling)
+        m_pollTimer->stop();
+}
+
+#include "moc_processspawner.cpp"
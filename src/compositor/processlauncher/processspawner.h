@@ -0,0 +1,90 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef PROCESSSPAWNER_H
+#define PROCESSSPAWNER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class QSocketNotifier;
+class QTimer;
+
+/*
+ * Spawns children with posix_spawn() instead of forking the whole
+ * compositor, passing them an environment block that is only rebuilt
+ * when one of the variables changes.
+ *
+ * Children are tracked with a pidfd each, all of them multiplexed on
+ * a single epoll descriptor watched by one socket notifier.
+ */
+class ProcessSpawner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProcessSpawner(QObject *parent = nullptr);
+    ~ProcessSpawner();
+
+    void setEnvironmentVariable(const QByteArray &name, const QByteArray &value);
+    void unsetEnvironmentVariable(const QByteArray &name);
+    void invalidateEnvironment();
+
+    qint64 spawn(const QString &program, const QStringList &arguments);
+
+    bool isRunning(qint64 pid) const;
+
+    bool terminate(qint64 pid);
+    bool kill(qint64 pid);
+    QList<qint64> waitForFinished(const QList<qint64> &pids, int msecs);
+
+Q_SIGNALS:
+    void finished(qint64 pid, int exitCode, bool crashed);
+
+private:
+    QHash<qint64, int> m_children;
+    int m_epollFd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_pollTimer = nullptr;
+
+    // Variables overriding the compositor environment, a null
+    // value removes the variable from the children environment
+    QMap<QByteArray, QByteArray> m_overrides;
+    bool m_environmentValid = false;
+    QVector<QByteArray> m_environment;
+    QVector<char *> m_envp;
+
+    void rebuildEnvironment();
+    bool reap(qint64 pid);
+
+private Q_SLOTS:
+    void pidfdActivated();
+    void pollChildren();
+};
+
+#endif // PROCESSSPAWNER_H
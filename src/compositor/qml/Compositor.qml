@@ -29,6 +29,7 @@ import Liri.Launcher 1.0 as Launcher
 import Liri.WaylandServer 1.0 as LiriWayland
 import Liri.Shell 1.0
 import Liri.PolicyKit 1.0
+import Liri.Device 1.0 as LiriDevice
 import Liri.private.shell 1.0 as P
 import "base"
 import "windows"
@@ -38,15 +39,13 @@ WaylandCompositor {
 
     property point mousePos: Qt.point(0, 0)
 
-    property int idleInhibit: 0
-
     readonly property alias screenManager: screenManager
 
     readonly property alias settings: settings
     readonly property alias shellSurfaces: shellSurfaces
 
-    readonly property bool hasMaxmizedShellSurfaces: __private.maximizedShellSurfaces > 0
-    readonly property bool hasFullscreenShellSurfaces: __private.fullscreenShellSurfaces > 0
+    readonly property bool hasMaxmizedShellSurfaces: shellSurfaces.maximizedCount > 0
+    readonly property bool hasFullscreenShellSurfaces: shellSurfaces.fullscreenCount > 0
 
     property Component outputConfigurationComponent: OutputConfiguration {}
 
@@ -83,41 +82,55 @@ WaylandCompositor {
     QtObject {
         id: __private
 
-        property int maximizedShellSurfaces: 0
-        property int fullscreenShellSurfaces: 0
-
         function createShellSurfaceItem(shellSurface, component, output) {
-            var parentSurfaceItem = output.viewsBySurface[shellSurface.parentWlSurface];
+            var parentSurfaceItem = shellSurfaces.view(output, shellSurface.parentWlSurface);
             var parent = parentSurfaceItem || output.surfacesArea;
             var item = component.createObject(parent, {
                                                   "compositor": liriCompositor,
-                                                  "shellSurface": shellSurface
+                                                  "shellSurface": shellSurface,
+                                                  "output": output
                                               });
-            output.viewsBySurface[shellSurface.surface] = item;
+            shellSurfaces.setView(output, shellSurface.surface, item);
             return item;
         }
 
         function handleShellSurfaceCreated(shellSurface, component) {
-            shellSurfaces.append({"shellSurface": shellSurface});
-
-            for (var i = 0; i < screenManager.count; i++)
-                createShellSurfaceItem(shellSurface, component, screenManager.objectAt(i));
+            // Views are created by the model on the outputs the window is on
+            shellSurfaces.add(shellSurface, component);
 
             liriCompositor.shellSurfaceCreated(shellSurface);
         }
 
-        function handleShellSurfaceDestroyed(shellSurface) {
-            if (shellSurface.maximized)
-                maximizedShellSurfaces--;
-            if (shellSurface.fullscreen)
-                fullscreenShellSurfaces--;
-
-            for (var i = 0; i < shellSurfaces.count; i++) {
-                if (shellSurfaces.get(i).shellSurface === shellSurface) {
-                    shellSurfaces.remove(i, 1);
-                    break;
+        function applyIdleStage(stage) {
+            var i, output;
+
+            // Scoped inhibitors keep awake only the outputs showing their
+            // windows, the others keep all of them awake
+            var processes = [];
+            var inhibitAll = false;
+            var inhibitors = SessionInterface.screenSaver.inhibitors;
+            for (i = 0; i < inhibitors.length; i++) {
+                if (inhibitors[i].scoped)
+                    processes.push(inhibitors[i].pid);
+                else
+                    inhibitAll = true;
+            }
+
+            for (i = 0; i < screenManager.count; i++) {
+                output = screenManager.objectAt(i);
+                if (stage === P.IdleMonitor.ActiveStage || inhibitAll ||
+                        output.idleInhibit > 0 || shellSurfaces.isOutputShowingProcesses(output, processes)) {
+                    output.wake();
+                } else {
+                    output.idle();
+                    if (stage >= P.IdleMonitor.BlankStage)
+                        output.standby();
                 }
             }
+        }
+
+        function handleShellSurfaceDestroyed(shellSurface) {
+            shellSurfaces.remove(shellSurface);
 
             applicationManager.unregisterShellSurface(shellSurface);
 
@@ -156,8 +169,10 @@ WaylandCompositor {
         }
     }
 
-    ListModel {
+    P.ShellSurfaceModel {
         id: shellSurfaces
+        onViewRequested: __private.createShellSurfaceItem(shellSurface, viewComponent(shellSurface), output)
+        onViewReleased: view.destroy()
     }
 
     /*
@@ -252,14 +267,7 @@ WaylandCompositor {
     Component {
         id: surfaceComponent
 
-        WaylandSurface {
-            id: surface
-
-            Component.onDestruction: {
-                for (var i = 0; i < screenManager.count; i++)
-                    delete screenManager.objectAt(i).viewsBySurface[surface];
-            }
-        }
+        WaylandSurface {}
     }
 
     // Custom wl_shell surface
@@ -291,20 +299,15 @@ WaylandCompositor {
             id: gtkSurface
 
             onAppIdChanged: {
-                for (var i = 0; i < shellSurfaces.count; i++) {
-                    var shellSurface = shellSurfaces.get(i).shellSurface;
-
-                    if (shellSurface.surface === gtkSurface.surface) {
-                        // Move surface under this appId because for some reason Gtk+ applications
-                        // are unable to provide a reliable appId via xdg-shell as opposed to gtk-shell
-                        shellSurface.canonicalAppId = appId;
-
-                        // Remove drop shadow and decoration for Gtk+ programs
-                        shellSurface.decorated = false;
-                        shellSurface.hasDropShadow = false;
-
-                        break;
-                    }
+                var shellSurface = shellSurfaces.findShellSurface(gtkSurface.surface);
+                if (shellSurface) {
+                    // Move surface under this appId because for some reason Gtk+ applications
+                    // are unable to provide a reliable appId via xdg-shell as opposed to gtk-shell
+                    shellSurface.canonicalAppId = appId;
+
+                    // Remove drop shadow and decoration for Gtk+ programs
+                    shellSurface.decorated = false;
+                    shellSurface.hasDropShadow = false;
                 }
             }
         }
@@ -391,22 +394,35 @@ WaylandCompositor {
         Component.onCompleted: registerAgent()
     }
 
-    Timer {
-        id: idleTimer
-        interval: settings.session.idleDelay * 1000
-        running: true
-        repeat: true
-        onTriggered: {
-            var i, output, idleHint = false;
-            for (i = 0; i < screenManager.count; i++) {
-                output = screenManager.objectAt(i);
-                if (idleInhibit + output.idleInhibit == 0) {
-                    output.idle();
-                    idleHint = true;
-                }
-            }
+    // Input is tracked natively, we only hear about stage changes
+    Connections {
+        target: SessionInterface.idleMonitor
+        onStageChanged: {
+            __private.applyIdleStage(stage);
+
+            if (stage === P.IdleMonitor.SuspendStage)
+                LiriDevice.LocalDevice.suspend();
+        }
+    }
+
+    Connections {
+        target: SessionInterface.screenSaver
+        onInhibitorsChanged: __private.applyIdleStage(SessionInterface.idleMonitor.stage)
+    }
+
+    // Inhibitors are scoped to the outputs of their windows, if they have any
+    Binding {
+        target: SessionInterface.screenSaver
+        property: "windowedProcesses"
+        value: shellSurfaces.processes
+    }
 
-            SessionInterface.idle = idleHint;
+    // Windows of inhibitors might move to another output while idle
+    Connections {
+        target: shellSurfaces
+        onViewsChanged: {
+            if (SessionInterface.idleMonitor.stage !== P.IdleMonitor.ActiveStage)
+                __private.applyIdleStage(SessionInterface.idleMonitor.stage);
         }
     }
 
@@ -415,13 +431,7 @@ WaylandCompositor {
      */
 
     function wake() {
-        var i;
-        for (i = 0; i < screenManager.count; i++) {
-            idleTimer.restart();
-            screenManager.objectAt(i).wake();
-        }
-
-        SessionInterface.idle = false;
+        SessionInterface.idleMonitor.reportActivity();
     }
 
     function idle() {
@@ -432,14 +442,22 @@ WaylandCompositor {
         SessionInterface.idle = true;
     }
 
+    function appIconUrl(iconName) {
+        // Reading the generation makes callers' bindings follow theme changes
+        if (Launcher.IconCache.generation < 0)
+            return "";
+        return Launcher.IconCache.iconUrl(iconName);
+    }
+
     function activateShellSurfaces(appId) {
-        for (var i = 0; i < shellSurfaces.count; i++) {
-            var shellSurface = shellSurfaces.get(i).shellSurface;
-            if (shellSurface.canonicalAppId === appId) {
-                shellSurface.minimized = false;
-                for (var j = 0; j < screenManager.count; j++)
-                    screenManager.objectAt(j).viewsBySurface[shellSurface.surface].takeFocus();
-            }
+        var list = shellSurfaces.shellSurfacesForAppId(appId);
+        for (var i = 0; i < list.length; i++) {
+            var shellSurface = list[i];
+            shellSurface.minimized = false;
+
+            var views = shellSurfaces.viewsForSurface(shellSurface.surface);
+            for (var j = 0; j < views.length; j++)
+                views[j].takeFocus();
         }
     }
 }
@@ -33,14 +33,14 @@ import "desktop"
 P.WaylandOutput {
     id: output
 
+    P.StartupSpan { name: "Output" }
+
     property bool primary: false
 
     property alias screen: outputSettings.screen
     property alias windowScreen: outputWindow.screen
     property alias powerState: outputSettings.powerState
 
-    property var viewsBySurface: ({})
-
     property int idleInhibit: 0
 
     readonly property alias screenView: screenView
@@ -50,8 +50,6 @@ P.WaylandOutput {
 
     property bool __idle: false
 
-    automaticFrameCallback: outputSettings.powerState === P.WaylandOutputSettings.PowerStateOn
-
     onPrimaryChanged: {
         // Set default output
         if (primary)
@@ -86,19 +84,8 @@ P.WaylandOutput {
 
         // Keyboard handling
         LiriShell.KeyEventFilter {
-            Keys.onPressed: {
-                // Input wakes the output
-                liriCompositor.wake();
-
-                screenView.handleKeyPressed(event);
-            }
-
-            Keys.onReleased: {
-                // Input wakes the output
-                liriCompositor.wake();
-
-                screenView.handleKeyReleased(event);
-            }
+            Keys.onPressed: screenView.handleKeyPressed(event)
+            Keys.onReleased: screenView.handleKeyReleased(event)
         }
 
         // Mouse tracker
@@ -109,21 +96,12 @@ P.WaylandOutput {
 
             windowSystemCursorEnabled: platformName !== "liri"
 
-            onMouseXChanged: {
-                // Wake up
-                liriCompositor.wake();
-
-                // Update global mouse position
-                liriCompositor.mousePos.x = output.position.x + mouseX;
-            }
-            onMouseYChanged: {
-                // Wake up
-                liriCompositor.wake();
-
+            // Reported at most once per frame
+            onMousePositionChanged: {
                 // Update global mouse position
-                liriCompositor.mousePos.y = output.position.y + mouseY;
+                liriCompositor.mousePos = Qt.point(output.position.x + mouseX,
+                                                   output.position.y + mouseY);
             }
-            // TODO: Need to wake up with mouse button pressed, released and wheel
 
             // User interface
             ScreenView {
@@ -164,6 +142,14 @@ P.WaylandOutput {
         id: outputSettings
     }
 
+    P.FrameRateGovernor {
+        output: output
+        dimmed: output.__idle
+        poweredOff: outputSettings.powerState !== P.WaylandOutputSettings.PowerStateOn
+        locked: SessionInterface.locked
+        throttled: SessionInterface.screenSaver.throttled
+    }
+
     /*
      * Methods
      */
@@ -182,8 +168,16 @@ P.WaylandOutput {
         if (__idle)
             return;
 
-        console.debug("Standby output", manufacturer, model);
+        console.debug("Dim output", manufacturer, model);
         idleDimmer.fadeIn();
         __idle = true;
     }
+
+    function standby() {
+        if (outputSettings.powerState !== P.WaylandOutputSettings.PowerStateOn)
+            return;
+
+        console.debug("Standby output", manufacturer, model);
+        outputSettings.powerState = P.WaylandOutputSettings.PowerStateStandby;
+    }
 }
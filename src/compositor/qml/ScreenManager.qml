@@ -34,17 +34,22 @@ Instantiator {
         id: screenModel
         fileName: screenConfigurationFileName
     }
+    onObjectAdded: liriCompositor.shellSurfaces.addOutput(object)
     onObjectRemoved: {
         // Move all windows that fit entirely the removed output to the primary output,
         // unless the output remove is the primary one (this shouldn't happen)
-        if (object === liriCompositor.defaultOutput)
-            return;
-        for (var surface in object.viewsBySurface) {
-            var view = object.viewsBySurface[surface];
-            if (view.primary && view.output === object) {
-                view.moveItem.x = liriCompositor.defaultOutput.position.x + 20;
-                view.moveItem.y = liriCompositor.defaultOutput.position.y + 20;
+        if (object !== liriCompositor.defaultOutput) {
+            var views = liriCompositor.shellSurfaces.viewsForOutput(object);
+            for (var i = 0; i < views.length; i++) {
+                var view = views[i];
+                if (view.primary && view.output === object) {
+                    view.moveItem.x = liriCompositor.defaultOutput.position.x + 20;
+                    view.moveItem.y = liriCompositor.defaultOutput.position.y + 20;
+                }
             }
         }
+
+        // Forget its views, windows left without a view get one elsewhere
+        liriCompositor.shellSurfaces.removeOutput(object);
     }
 }
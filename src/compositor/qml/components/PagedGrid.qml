@@ -66,9 +66,12 @@ Item {
         currentIndex: 0
         clip: true
 
+        // Keep the neighbouring pages around for flicking, but no more
+        cacheBuffer: pagedGrid.width
+
         model: Math.ceil(pagedGrid.count/pageCount)
 
-        delegate: Grid {
+        delegate: Loader {
             id: page
 
             readonly property int pageIndex: index
@@ -76,17 +79,22 @@ Item {
             width: pagedGrid.width
             height: pagedGrid.height
 
-            columns: pagedGrid.columns
+            // Only populate the current page and its neighbours
+            active: Math.abs(pageIndex - pageView.currentIndex) <= 1
 
-            Repeater {
-                model: PageModel {
-                    id: pageModel
-                    sourceModel: pagedGrid.model
-                    startIndex: pageCount * pageIndex
-                    limitCount: pageCount
-                }
+            sourceComponent: Grid {
+                columns: pagedGrid.columns
 
-                delegate: pagedGrid.delegate
+                Repeater {
+                    model: PageModel {
+                        id: pageModel
+                        sourceModel: pagedGrid.model
+                        startIndex: pageCount * page.pageIndex
+                        limitCount: pageCount
+                    }
+
+                    delegate: pagedGrid.delegate
+                }
             }
         }
     }
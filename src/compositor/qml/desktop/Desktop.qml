@@ -22,21 +22,25 @@
  * $END_LICENSE$
  ***************************************************************************/
 
-import QtQuick 2.0
+import QtQuick 2.7
 import QtWayland.Compositor 1.0 as QtWaylandCompositor
 import QtGraphicalEffects 1.0
 import QtQuick.Controls 2.0
 import QtQuick.Controls.Material 2.0
 import Fluid.Controls 1.0 as FluidControls
 import Liri.Shell 1.0
+import Liri.private.shell 1.0 as P
 import ".."
 import "../components"
 import "../indicators"
 import "../notifications"
+import Liri.Notifications 1.0
 
 Item {
     id: desktop
 
+    P.StartupSpan { name: "Desktop" }
+
     Material.theme: Material.Dark
     Material.primary: Material.Blue
     Material.accent: Material.Blue
@@ -170,9 +174,12 @@ Item {
         }
     }
 
-    // Notifications are behind the panel
+    // Notifications are behind the panel, created with the first one
     Loader {
         id: notificationsLayer
+
+        property bool loadComponent: false
+
         anchors {
             top: parent.top
             right: parent.right
@@ -180,12 +187,25 @@ Item {
             topMargin: FluidControls.Units.largeSpacing * 3
             bottomMargin: 56 + FluidControls.Units.smallSpacing
         }
-        active: output.primary
+        active: output.primary && loadComponent
         sourceComponent: Notifications {}
         width: FluidControls.Units.gu(24) + (2 * FluidControls.Units.smallSpacing)
         z: 10
     }
 
+    Connections {
+        target: NotificationsService
+        enabled: output.primary
+        onNotificationReceived: {
+            notificationsLayer.loadComponent = true;
+            notificationsLayer.item.addNotification({"id": notificationId, "appName": appName,
+                                                        "appIcon": appIcon, "hasIcon": hasIcon,
+                                                        "summary": summary, "body": body,
+                                                        "actions": actions, "isPersistent": isPersistent,
+                                                        "expireTimeout": expireTimeout, "hints": hints});
+        }
+    }
+
     // Windows switcher
     WindowSwitcher {
         id: windowSwitcher
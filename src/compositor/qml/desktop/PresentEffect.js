@@ -47,11 +47,8 @@ function spreadWindows() {
         var offsetX = (workspaceWidth - row.width) / 2;
 
         row.windows.forEach(function(pos) {
-            var shellSurface = liriCompositor.shellSurfaces.get(pos.index).shellSurface;
-            if (!shellSurface)
-                return;
-
-            var entry = output.viewsBySurface[shellSurface.surface];
+            var entry = pos.view;
+            var shellSurface = entry.shellSurface;
 
             // Calculate position and size
             var x = output.position.x + pos.x + ((workspaceWidth - row.width) / 2);
@@ -90,19 +87,11 @@ function spreadWindows() {
 }
 
 function restoreWindows() {
-    // This loop needs to run on all shell surfaces so we make their views
+    // This loop needs to run on all views so we make them
     // visible again on restore
-    for (var i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-        var shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-        if (!shellSurface)
-            continue;
-
-        var entry = output.viewsBySurface[shellSurface.surface];
-
-        // Ignore undefined entries, happens with some Qt wl-shell clients
-        if (entry === undefined)
-            continue;
-
+    var views = liriCompositor.shellSurfaces.viewsForOutput(output);
+    for (var i = 0; i < views.length; i++) {
+        var entry = views[i];
         var pos = originalLayout[entry];
         if (pos !== undefined) {
             // Restore to the original position and size
@@ -145,18 +134,12 @@ function tryLayout(rows) {
     var row = 0;
     var rowList = [];
     var list = [];
+    var views = liriCompositor.shellSurfaces.viewsForOutput(output);
     var i, shellSurface, entry;
 
-    for (i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-        shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-        if (!shellSurface)
-            continue;
-
-        entry = output.viewsBySurface[shellSurface.surface];
-
-        // Ignore undefined entries, happens with some Qt wl-shell clients
-        if (entry === undefined)
-            continue;
+    for (i = 0; i < views.length; i++) {
+        entry = views[i];
+        shellSurface = entry.shellSurface;
 
         // Only top level windows
         if (shellSurface.windowType !== Qt.Window)
@@ -169,16 +152,9 @@ function tryLayout(rows) {
         rowHeight = Math.min(rowHeight, entry.height);
     }
 
-    for (i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-        shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-        if (!shellSurface)
-            continue;
-
-        entry = output.viewsBySurface[shellSurface.surface];
-
-        // Ignore undefined entries, happens with some Qt wl-shell clients
-        if (entry === undefined)
-            continue;
+    for (i = 0; i < views.length; i++) {
+        entry = views[i];
+        shellSurface = entry.shellSurface;
 
         // Only top level windows
         if (shellSurface.windowType !== Qt.Window) {
@@ -211,7 +187,7 @@ function tryLayout(rows) {
                          "x": rowWidth,
                          "y": spacing + (rowHeight + spacing) * row,
                          "scale": scale,
-                         "index": i
+                         "view": entry
                      });
 
         rowWidth += windowWidth + spacing;
@@ -245,22 +221,12 @@ function isEntryOnOutput(entry, output) {
 
 // Calculate spacing between windows based on how many of them there are
 function calcSpacing() {
+    var views = liriCompositor.shellSurfaces.viewsForOutput(output);
     var count = 0;
-    var i, shellSurface, entry;
-
-    for (i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-        shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-        if (!shellSurface)
-            continue;
-
-        entry = output.viewsBySurface[shellSurface.surface];
-
-        // Ignore undefined entries, happens with some Qt wl-shell clients
-        if (entry === undefined)
-            continue;
 
+    for (var i = 0; i < views.length; i++) {
         // Count only windows on this output
-        if (isEntryOnOutput(entry, output))
+        if (isEntryOnOutput(views[i], output))
             count++;
     }
 
@@ -119,7 +119,7 @@ Item {
                 centerIn: parent
                 margins: FluidControls.Units.smallSpacing
             }
-            name: view.shellSurface.iconName
+            source: liriCompositor.appIconUrl(view.shellSurface.iconName || "unknown")
             width: FluidControls.Units.iconSizes.large
             height: width
         }
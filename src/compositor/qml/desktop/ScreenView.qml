@@ -65,17 +65,17 @@ Item {
         State {
             name: "logout"
             PropertyChanges { target: screenView; cursorVisible: true }
-            PropertyChanges { target: logoutScreen; active: true }
+            PropertyChanges { target: logoutScreen; screenActive: true }
         },
         State {
             name: "poweroff"
             PropertyChanges { target: screenView; cursorVisible: true }
-            PropertyChanges { target: powerScreen; active: true; mode: "poweroff" }
+            PropertyChanges { target: powerScreen; screenActive: true; mode: "poweroff" }
         },
         State {
             name: "restart"
             PropertyChanges { target: screenView; cursorVisible: true }
-            PropertyChanges { target: powerScreen; active: true; mode: "restart" }
+            PropertyChanges { target: powerScreen; screenActive: true; mode: "restart" }
         },
         State {
             name: "lock"
@@ -92,8 +92,6 @@ Item {
         target: SessionInterface
         onSessionLocked: screenView.state = "lock"
         onSessionUnlocked: screenView.state = "session"
-        onIdleInhibitRequested: liriCompositor.idleInhibit++
-        onIdleUninhibitRequested: liriCompositor.idleInhibit--
         onShutdownRequestCanceled: screenView.state = "session"
         onLogOutRequested: if (screenView.state != "lock") screenView.state = "logout"
         onPowerOffRequested: if (screenView.state != "lock") screenView.state = "poweroff"
@@ -325,16 +323,37 @@ Item {
      * Logout and power off
      */
 
-    LogoutScreen {
+    // Created the first time they are needed
+    Loader {
         id: logoutScreen
 
-        onCanceled: SessionInterface.cancelShutdownRequest()
+        property bool screenActive: false
+
+        anchors.fill: parent
+        active: false
+        onScreenActiveChanged: if (screenActive) active = true
+        sourceComponent: LogoutScreen {
+            active: logoutScreen.screenActive
+
+            onCanceled: SessionInterface.cancelShutdownRequest()
+        }
     }
 
-    PowerScreen {
+    Loader {
         id: powerScreen
 
-        onCanceled: SessionInterface.cancelShutdownRequest()
+        property bool screenActive: false
+        property string mode: "poweroff"
+
+        anchors.fill: parent
+        active: false
+        onScreenActiveChanged: if (screenActive) active = true
+        sourceComponent: PowerScreen {
+            active: powerScreen.screenActive
+            mode: powerScreen.mode
+
+            onCanceled: SessionInterface.cancelShutdownRequest()
+        }
     }
 
     /*
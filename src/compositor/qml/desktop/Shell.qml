@@ -28,11 +28,14 @@ import QtQuick.Controls 2.0
 import QtQuick.Controls.Material 2.0
 import Fluid.Core 1.0 as FluidCore
 import Fluid.Controls 1.0 as FluidControls
+import Liri.private.shell 1.0 as P
 import "../panel"
 
 Item {
     id: shell
 
+    P.StartupSpan { name: "Shell" }
+
     readonly property alias panel: panel
     readonly property alias indicator: rightDrawer.indicator
 
@@ -48,7 +48,8 @@ Popup {
         id: thumbnailComponent
 
         Rectangle {
-            readonly property var view: liriCompositor.defaultOutput.viewsBySurface[shellSurface.surface]
+            readonly property var view: liriCompositor.shellSurfaces.view(liriCompositor.defaultOutput, shellSurface.surface) ||
+                                        liriCompositor.shellSurfaces.viewsForSurface(shellSurface.surface)[0]
             readonly property string title: shellSurface.title ? shellSurface.title : qsTr("Untitled")
             readonly property real ratio: view.width / view.height
 
@@ -84,8 +85,7 @@ Popup {
                 }
                 width: FluidControls.Units.iconSizes.large
                 height: width
-                name: view.shellSurface.iconName
-                cache: false
+                source: liriCompositor.appIconUrl(view.shellSurface.iconName || "unknown")
                 z: 1
             }
         }
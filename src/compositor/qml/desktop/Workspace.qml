@@ -135,10 +135,9 @@ Item {
         // Loop over windows
         console.time("reveal loop " + output.model);
         var x, y;
-        for (var i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-            // Get a hold of the shell surface
-            var shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-            var view = output.viewsBySurface[shellSurface.surface];
+        var views = liriCompositor.shellSurfaces.viewsForOutput(output);
+        for (var i = 0; i < views.length; i++) {
+            var view = views[i];
 
             // Skip shell surfaces not rendered on this output
             if (!view.primary)
@@ -169,10 +168,9 @@ Item {
 
     function revealRestore() {
         // Restore windows position
-        for (var i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-            // Get a hold of the shell surface
-            var shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-            var view = output.viewsBySurface[shellSurface.surface];
+        var views = liriCompositor.shellSurfaces.viewsForOutput(output);
+        for (var i = 0; i < views.length; i++) {
+            var view = views[i];
 
             var pos = __private.storage[view];
             if (pos !== undefined) {
@@ -33,18 +33,26 @@ Indicator {
     id: indicator
     title: qsTr("Applications")
     iconView: AppsIcon {}
-    active: popover.visible
-    onClicked: popover.open()
+    active: popoverLoader.item ? popoverLoader.item.visible : false
+    onClicked: {
+        popoverLoader.active = true;
+        popoverLoader.item.open();
+    }
+
+    // Created the first time it's opened
+    Loader {
+        id: popoverLoader
 
-    Launcher.LauncherPopOver {
-        id: popover
-        x: (parent.width - width)/2
-        y: (parent.height - height)/2
+        active: false
+        sourceComponent: Launcher.LauncherPopOver {
+            x: (parent.width - width)/2
+            y: (parent.height - height)/2
 
-        parent: screenView
+            parent: screenView
 
-        modal: true
+            modal: true
 
-        onAppLaunched: close()
+            onAppLaunched: close()
+        }
     }
 }
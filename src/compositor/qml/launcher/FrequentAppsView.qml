@@ -31,12 +31,10 @@ Item {
         Repeater {
             id: repeater
 
-            model: PageModel {
+            model: FrequentAppsModel {
+                id: frequentAppsModel
+                sourceModel: applicationManager
                 limitCount: grid.rows * grid.columns
-                sourceModel: FrequentAppsModel {
-                    id: frequentAppsModel
-                    sourceModel: applicationManager
-                }
             }
 
             delegate: Item {
@@ -84,7 +84,7 @@ LiriShell.PanelItem {
     FluidControls.Icon {
         id: icon
         anchors.centerIn: parent
-        name: model.iconName || "application-x-executable"
+        source: model.decoration || liriCompositor.appIconUrl("application-x-executable")
         size: parent.height * 0.55
     }
 
@@ -128,29 +128,22 @@ LiriShell.PanelItem {
         launcher.currentIndex = index;
 
         // Minimize or unminimize shell surfaces
-        for (var i = 0; i < liriCompositor.shellSurfaces.count; i++) {
-            var shellSurface = liriCompositor.shellSurfaces.get(i).shellSurface;
-            if (!shellSurface)
-                continue;
-
-            if (shellSurface.canonicalAppId === model.appId) {
-                // Task icon position
-                var pt = screenView.mapFromItem(launcherItem, launcherItem.width * 0.5, launcherItem.height * 0.5);
-                pt.x += output.position.x;
-                pt.y += output.position.y;
-
-                // Set task icon geometry and toggle minimization
-                for (var j = 0; j < liriCompositor.screenManager.count; j++) {
-                    var curOutput = liriCompositor.screenManager.objectAt(j);
-                    for (var surface in curOutput.viewsBySurface) {
-                        var view = curOutput.viewsBySurface[surface];
-                        view.taskIconGeometry = Qt.rect(pt.x, pt.y, launcherItem.width, launcherItem.height);
-                    }
-                }
-
-                // Toggle minimization
-                shellSurface.minimized = !shellSurface.minimized;
-            }
+        var shellSurfaces = liriCompositor.shellSurfaces.shellSurfacesForAppId(model.appId);
+        for (var i = 0; i < shellSurfaces.length; i++) {
+            var shellSurface = shellSurfaces[i];
+
+            // Task icon position
+            var pt = screenView.mapFromItem(launcherItem, launcherItem.width * 0.5, launcherItem.height * 0.5);
+            pt.x += output.position.x;
+            pt.y += output.position.y;
+
+            // Set task icon geometry and toggle minimization
+            var views = liriCompositor.shellSurfaces.viewsForSurface(shellSurface.surface);
+            for (var j = 0; j < views.length; j++)
+                views[j].taskIconGeometry = Qt.rect(pt.x, pt.y, launcherItem.width, launcherItem.height);
+
+            // Toggle minimization
+            shellSurface.minimized = !shellSurface.minimized;
         }
     }
 
@@ -62,7 +62,7 @@ Rectangle {
             margins: 2 * FluidControls.Units.smallSpacing
         }
         size: height
-        name: model.iconName
+        source: model.decoration
     }
 
     Label {
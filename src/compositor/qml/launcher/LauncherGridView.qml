@@ -32,7 +32,7 @@ import "../components"
 PagedGrid {
     id: gridView
 
-    property alias query: appsProxyModel.filterPattern
+    property alias query: searchModel.query
 
     property int cellSize: 130
 
@@ -43,23 +43,12 @@ PagedGrid {
     columns: 6
 
     function filterByCategory(category) {
-        appsCategoryProxyModel.filterPattern = category;
+        searchModel.category = category;
     }
 
-    model: SortFilterProxyModel {
-        id: appsProxyModel
-        sourceModel: SortFilterProxyModel {
-            id: appsCategoryProxyModel
-            sourceModel: applicationManager
-            filterRoleName: "categories"
-            filterCaseSensitivity: Qt.CaseInsensitive
-        }
-        filterRoleName: "filterInfo"
-        filterCaseSensitivity: Qt.CaseInsensitive
-        isSortLocaleAware: true
-        sortCaseSensitivity: Qt.CaseSensitive
-        sortOrder: Qt.AscendingOrder
-        sortRoleName: "name"
+    model: SearchModel {
+        id: searchModel
+        sourceModel: applicationManager
     }
 
     delegate: Item {
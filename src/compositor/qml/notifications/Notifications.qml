@@ -23,7 +23,6 @@
 
 import QtQuick 2.5
 import Fluid.Controls 1.0
-import Liri.Notifications 1.0
 
 ListView {
     id: listView
@@ -66,15 +65,8 @@ ListView {
         }
     }
 
-    Connections {
-        target: NotificationsService
-        onNotificationReceived: {
-            notificationsModel.append({"id": notificationId, "appName": appName,
-                                          "appIcon": appIcon, "hasIcon": hasIcon,
-                                          "summary": summary, "body": body,
-                                          "actions": actions, "isPersistent": isPersistent,
-                                          "expireTimeout": expireTimeout, "hints": hints})
-        }
+    function addNotification(notification) {
+        notificationsModel.append(notification)
     }
 
     function removeNotification(id) {
@@ -48,6 +48,12 @@ Item {
             logoutDialog.close()
     }
 
+    // Created on demand, possibly while already active
+    Component.onCompleted: {
+        if (active && output.primary)
+            logoutDialog.open()
+    }
+
     Timer {
         running: logoutDialog.visible
         interval: 1000
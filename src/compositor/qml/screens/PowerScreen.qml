@@ -44,6 +44,12 @@ Item {
             powerDialog.close()
     }
 
+    // Created on demand, possibly while already active
+    Component.onCompleted: {
+        if (active && output.primary)
+            powerDialog.open()
+    }
+
     Rectangle {
         anchors.fill: parent
 
@@ -115,10 +115,10 @@ Control {
                     verticalCenter: parent.verticalCenter
                 }
 
-                name: shellSurface.iconName
+                source: liriCompositor.appIconUrl(shellSurface.iconName)
                 width: 24
                 height: width
-                visible: name != "" && status == Image.Ready
+                visible: source != "" && status == Image.Ready
             }
 
             Label {
@@ -34,7 +34,11 @@ LS.ChromeItem {
     property alias shellSurface: shellSurfaceItem.shellSurface
     property alias moveItem: shellSurfaceItem.moveItem
     property alias inputEventsEnabled: shellSurfaceItem.inputEventsEnabled
-    readonly property alias output: shellSurfaceItem.output
+    readonly property alias moving: shellSurfaceItem.moving
+    property WaylandOutput output: null
+
+    // Set by the shell surface model when windows above cover this one
+    property bool occluded: false
 
     property rect taskIconGeometry: Qt.rect(0, 0, 32, 32)
 
@@ -57,7 +61,7 @@ LS.ChromeItem {
         Scale {
             id: scaleTransformPos
             origin.x: shellSurfaceItem.width / 2
-            origin.y: chrome.y - shellSurfaceItem.output.position.y - shellSurfaceItem.height
+            origin.y: chrome.y - output.position.y - shellSurfaceItem.height
         }
     ]
 
@@ -94,7 +98,7 @@ LS.ChromeItem {
         }
 
         function setPosition() {
-            var parentSurfaceItem = output.viewsBySurface[shellSurface.parentWlSurface];
+            var parentSurfaceItem = liriCompositor.shellSurfaces.view(output, shellSurface.parentWlSurface);
             if (parentSurfaceItem) {
                 moveItem.x = parentSurfaceItem.moveItem.x + shellSurface.offset.x;
                 moveItem.y = parentSurfaceItem.moveItem.y + shellSurface.offset.y;
@@ -108,7 +112,7 @@ LS.ChromeItem {
 
         function giveFocusToParent() {
             // Give focus back to the parent on destruction
-            var parentSurfaceItem = output.viewsBySurface[shellSurfaceItem.parentWlSurface];
+            var parentSurfaceItem = liriCompositor.shellSurfaces.view(output, shellSurfaceItem.parentWlSurface);
             if (parentSurfaceItem)
                 parentSurfaceItem.takeFocus();
         }
@@ -124,8 +128,13 @@ LS.ChromeItem {
 
         moveItem: shellSurface.moveItem
 
+        // Hidden windows are not drawn, the shell surface model also
+        // holds back their frame callbacks so clients stop rendering
+        output: chrome.output
+        visible: !chrome.occluded
+
         // FIXME: Transparent backgrounds will be opaque due to shadows
-        layer.enabled: !shellSurface.decorated
+        layer.enabled: !shellSurface.decorated && !chrome.occluded
         layer.effect: FluidEffects.Elevation {
             elevation: shellSurfaceItem.focus ? 24 : 8
         }
@@ -196,6 +205,7 @@ LS.ChromeItem {
             onActivatedChanged: {
                 if (shellSurface.activated) {
                     chrome.raise();
+                    liriCompositor.shellSurfaces.raise(shellSurface);
                     focusAnimation.start();
                 }
             }
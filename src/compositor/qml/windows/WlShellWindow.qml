@@ -101,18 +101,6 @@ P.WlShellSurface {
     onSetFullScreen: {
         fullscreen = true;
     }
-    onMaximizedChanged: {
-        if (maximized)
-            __private.maximizedShellSurfaces++;
-        else
-            __private.maximizedShellSurfaces--;
-    }
-    onFullscreenChanged: {
-        if (fullscreen)
-            __private.fullscreenShellSurfaces++;
-        else
-            __private.fullscreenShellSurfaces--;
-    }
     onPong: {
         pingTimer.stop();
         details.responsive = true;
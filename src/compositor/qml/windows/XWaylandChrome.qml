@@ -35,7 +35,10 @@ LS.ChromeItem {
     property alias shellSurface: shellSurfaceItem.shellSurface
     property alias moveItem: shellSurfaceItem.moveItem
     property alias inputEventsEnabled: shellSurfaceItem.inputEventsEnabled
-    readonly property alias output: shellSurfaceItem.output
+    property WaylandOutput output: null
+
+    // Set by the shell surface model when windows above cover this one
+    property bool occluded: false
 
     property rect taskIconGeometry: Qt.rect(0, 0, 32, 32)
 
@@ -56,7 +59,7 @@ LS.ChromeItem {
         Scale {
             id: scaleTransformPos
             origin.x: shellSurfaceItem.width / 2
-            origin.y: chrome.y - shellSurfaceItem.output.position.y - shellSurfaceItem.height
+            origin.y: chrome.y - output.position.y - shellSurfaceItem.height
         }
     ]
 
@@ -107,8 +110,10 @@ LS.ChromeItem {
 
         dragTarget: shellSurface.xwaylandMoveItem
 
+        visible: shellSurface.decorated && !shellSurface.fullscreen && !chrome.occluded
+
         // FIXME: Transparent backgrounds will be opaque due to shadows
-        layer.enabled: shellSurface.decorated && shellSurface.hasDropShadow
+        layer.enabled: shellSurface.decorated && shellSurface.hasDropShadow && !chrome.occluded
         layer.effect: FluidEffects.Elevation {
             elevation: shellSurfaceItem.focus ? 24 : 8
         }
@@ -122,8 +127,13 @@ LS.ChromeItem {
 
         moveItem: shellSurface.moveItem
 
+        // Hidden windows are not drawn, the shell surface model also
+        // holds back their frame callbacks so clients stop rendering
+        output: chrome.output
+        visible: !chrome.occluded
+
         // FIXME: Transparent backgrounds will be opaque due to shadows
-        layer.enabled: !shellSurface.decorated
+        layer.enabled: !shellSurface.decorated && !chrome.occluded
         layer.effect: FluidEffects.Elevation {
             elevation: shellSurfaceItem.focus ? 24 : 8
         }
@@ -184,6 +194,7 @@ LS.ChromeItem {
                 if (shellSurface.activated) {
                     applicationManager.focusShellSurface(shellSurface);
                     chrome.raise();
+                    liriCompositor.shellSurfaces.raise(shellSurface);
                     focusAnimation.start();
                 }
             }
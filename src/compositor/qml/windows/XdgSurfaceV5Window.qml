@@ -81,10 +81,6 @@ P.XdgSurfaceV5 {
         offset.y = (parentSurface.windowGeometry.height - windowGeometry.height) / 2;
     }
     onSetMinimized: minimized = true
-    onSetMaximized: __private.maximizedShellSurfaces++
-    onUnsetMaximized: __private.maximizedShellSurfaces--
-    onSetFullscreen: __private.fullscreenShellSurfaces++
-    onUnsetFullscreen: __private.fullscreenShellSurfaces--
 
     QtObject {
         id: details
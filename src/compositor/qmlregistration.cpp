@@ -28,16 +28,20 @@
 
 #include "qmlregistration.h"
 
+#include "declarative/framerategovernor.h"
 #include "declarative/indicatorsmodel.h"
 #include "declarative/inputsettings.h"
 #include "declarative/outputsettings.h"
 #include "declarative/quickoutput.h"
 #include "declarative/screenmodel.h"
+#include "declarative/shellsurfacemodel.h"
+#include "declarative/startupspan.h"
 #include "extensions/gtkshell.h"
 #include "extensions/outputchangeset.h"
 #include "extensions/outputconfiguration.h"
 #include "extensions/outputmanagement.h"
 #include "extensions/quickoutputconfiguration.h"
+#include "sessionmanager/idlemonitor.h"
 
 #ifndef Q_COMPOSITOR_DECLARE_QUICK_PARENT_CLASS
 #define Q_COMPOSITOR_DECLARE_QUICK_PARENT_CLASS(className) \
@@ -93,6 +97,9 @@ void registerPrivateTypes()
     const int versionMajor = 1;
     const int versionMinor = 0;
 
+    qmlRegisterType<FrameRateGovernor>(uri, versionMajor, versionMinor, "FrameRateGovernor");
+    qmlRegisterUncreatableType<IdleMonitor>(uri, versionMajor, versionMinor, "IdleMonitor",
+                                            QLatin1String("Cannot create instance of IdleMonitor"));
     qmlRegisterType<IndicatorsModel>(uri, versionMajor, versionMinor, "IndicatorsModel");
     qmlRegisterType<InputSettings>(uri, versionMajor, versionMinor, "InputSettings");
     qmlRegisterType<QuickOutputQuickParent>(uri, versionMajor, versionMinor, "WaylandOutput");
@@ -102,6 +109,8 @@ void registerPrivateTypes()
                                            QLatin1String("Cannot create instance of ScreenMode"));
     qmlRegisterUncreatableType<ScreenItem>(uri, versionMajor, versionMinor, "ScreenItem",
                                            QLatin1String("Cannot create instance of ScreenItem"));
+    qmlRegisterType<ShellSurfaceModel>(uri, versionMajor, versionMinor, "ShellSurfaceModel");
+    qmlRegisterType<StartupSpan>(uri, versionMajor, versionMinor, "StartupSpan");
 
     qmlRegisterType<QWaylandWlShellQuickExtension>(uri, versionMajor, versionMinor, "WlShell");
     qmlRegisterType<QWaylandWlShellSurfaceQuickParent>(uri, versionMajor, versionMinor, "WlShellSurface");
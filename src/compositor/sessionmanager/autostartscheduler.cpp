@@ -0,0 +1,231 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QTimer>
+#include <QtQuick/QQuickWindow>
+
+#include <Qt5GSettings/QGSettings>
+
+#include "autostartscheduler.h"
+#include "processlauncher/processlauncher.h"
+#include "sessionmanager.h"
+#include "startuptrace.h"
+
+// How many entries are starting at the same time by default
+#define AUTOSTART_DEFAULT_CONCURRENCY 2
+
+/*
+ * Time an entry keeps its slot while starting, unless it exits earlier:
+ * most of the startup I/O and CPU burst is over by then
+ */
+#define AUTOSTART_STARTUP_TIME_MS 1000
+
+// Start anyway if no frame was presented within this time
+#define AUTOSTART_GATE_TIMEOUT_MS (10 * 1000)
+
+AutostartScheduler::AutostartScheduler(ProcessLauncher *launcher, QObject *parent)
+    : QObject(parent)
+    , m_launcher(launcher)
+    , m_settings(new QtGSettings::QGSettings(QStringLiteral("io.liri.session"),
+                                             QStringLiteral("/io/liri/session/"),
+                                             this))
+    , m_maxConcurrent(AUTOSTART_DEFAULT_CONCURRENCY)
+    , m_gateTimer(new QTimer(this))
+    , m_delayTimer(new QTimer(this))
+{
+    m_clock.start();
+
+    settingChanged(QStringLiteral("autostartConcurrency"));
+    connect(m_settings, &QtGSettings::QGSettings::settingChanged,
+            this, &AutostartScheduler::settingChanged);
+
+    m_gateTimer->setSingleShot(true);
+    m_gateTimer->setInterval(AUTOSTART_GATE_TIMEOUT_MS);
+    connect(m_gateTimer, &QTimer::timeout, this, [this] {
+        qCWarning(SESSION_MANAGER, "No frame presented in %d ms, starting autostart entries anyway",
+                  AUTOSTART_GATE_TIMEOUT_MS);
+        start();
+    });
+
+    m_delayTimer->setSingleShot(true);
+    connect(m_delayTimer, &QTimer::timeout, this, &AutostartScheduler::launchNext);
+
+    connect(m_launcher, &ProcessLauncher::applicationFinished,
+            this, &AutostartScheduler::release);
+}
+
+int AutostartScheduler::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void AutostartScheduler::setMaxConcurrent(int value)
+{
+    value = qMax(1, value);
+    if (m_maxConcurrent == value)
+        return;
+
+    m_maxConcurrent = value;
+    if (m_started)
+        launchNext();
+}
+
+bool AutostartScheduler::isStarted() const
+{
+    return m_started;
+}
+
+void AutostartScheduler::schedule(const XdgDesktopFile &entry)
+{
+    Entry item;
+    item.desktopFile = entry;
+    item.priority = priorityForEntry(entry);
+    item.delay = qMax(0, entry.value(QStringLiteral("X-GNOME-Autostart-Delay")).toInt()) * 1000;
+
+    // Keep the queue sorted by priority, in the order entries come
+    auto it = m_queue.begin();
+    while (it != m_queue.end() && it->priority <= item.priority)
+        ++it;
+    m_queue.insert(it, item);
+
+    qCDebug(SESSION_MANAGER) << "Autostart:" << entry.name() << "from" << entry.fileName()
+                             << "scheduled with" << item.priority << "and delay" << item.delay << "ms";
+
+    if (m_started)
+        launchNext();
+}
+
+void AutostartScheduler::startAfterFirstFrame(QQuickWindow *window)
+{
+    if (m_started)
+        return;
+
+    if (!window) {
+        start();
+        return;
+    }
+
+    // Swaps are emitted by the render thread
+    m_gateConnection = connect(window, &QQuickWindow::frameSwapped,
+                               this, &AutostartScheduler::start,
+                               Qt::QueuedConnection);
+    m_gateTimer->start();
+}
+
+void AutostartScheduler::start()
+{
+    if (m_started)
+        return;
+
+    disconnect(m_gateConnection);
+    m_gateTimer->stop();
+
+    m_started = true;
+    m_clock.restart();
+
+    qCDebug(SESSION_MANAGER, "Starting %d autostart entries, %d at a time",
+             m_queue.size(), m_maxConcurrent);
+
+    launchNext();
+}
+
+AutostartScheduler::Priority AutostartScheduler::priorityForEntry(const XdgDesktopFile &entry)
+{
+    const QString priority = entry.value(QStringLiteral("X-Liri-Autostart-Priority")).toString();
+    if (priority == QLatin1String("agent"))
+        return AgentPriority;
+    else if (priority == QLatin1String("tray"))
+        return TrayPriority;
+    else if (priority == QLatin1String("application"))
+        return ApplicationPriority;
+
+    // Anything starting before the applications phase is part of the session
+    const QString phase = entry.value(QStringLiteral("X-GNOME-Autostart-Phase")).toString();
+    if (!phase.isEmpty() && phase != QLatin1String("Applications"))
+        return AgentPriority;
+    bool ok = false;
+    const int kdePhase = entry.value(QStringLiteral("X-KDE-autostart-phase")).toInt(&ok);
+    if (ok && kdePhase < 2)
+        return AgentPriority;
+
+    const QStringList categories =
+            entry.value(QStringLiteral("Categories")).toString().split(QLatin1Char(';'), QString::SkipEmptyParts);
+    if (categories.contains(QStringLiteral("TrayIcon")))
+        return TrayPriority;
+
+    return ApplicationPriority;
+}
+
+void AutostartScheduler::launchNext()
+{
+    const qint64 now = m_clock.elapsed();
+    qint64 nextDelay = -1;
+
+    auto it = m_queue.begin();
+    while (it != m_queue.end() && m_running.size() < m_maxConcurrent) {
+        // Deferred entries don't hold back the following ones
+        if (it->delay > now) {
+            if (nextDelay < 0 || it->delay < nextDelay)
+                nextDelay = it->delay;
+            ++it;
+            continue;
+        }
+
+        const XdgDesktopFile entry = it->desktopFile;
+        it = m_queue.erase(it);
+
+        const QString fileName = entry.fileName();
+        if (!m_launcher->launchEntry(entry)) {
+            qCWarning(SESSION_MANAGER) << "Autostart:" << entry.name() << "from" << fileName
+                                       << "failed to start";
+            continue;
+        }
+
+        qCInfo(SESSION_MANAGER) << "Autostart:" << entry.name() << "from" << fileName
+                                << "started" << m_clock.elapsed() << "ms after the first frame";
+        StartupTrace::instant(QStringLiteral("Autostart %1").arg(entry.name()));
+
+        m_running.insert(fileName);
+        QTimer::singleShot(AUTOSTART_STARTUP_TIME_MS, this, [this, fileName] {
+            release(fileName);
+        });
+    }
+
+    if (nextDelay >= 0 && m_running.size() < m_maxConcurrent)
+        m_delayTimer->start(int(nextDelay - now));
+}
+
+void AutostartScheduler::release(const QString &fileName)
+{
+    if (m_running.remove(fileName))
+        launchNext();
+}
+
+void AutostartScheduler::settingChanged(const QString &key)
+{
+    if (key == QLatin1String("autostartConcurrency"))
+        setMaxConcurrent(m_settings->value(key).toInt());
+}
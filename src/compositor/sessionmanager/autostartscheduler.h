@@ -0,0 +1,107 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef AUTOSTARTSCHEDULER_H
+#define AUTOSTARTSCHEDULER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+
+#include <qt5xdg/xdgdesktopfile.h>
+
+class QQuickWindow;
+class QTimer;
+
+class ProcessLauncher;
+
+namespace QtGSettings {
+class QGSettings;
+}
+
+/*
+ * Starts autostart entries once the compositor has presented its
+ * first frame, a few at a time and by priority class: session agents
+ * first, then tray applications and finally everything else.
+ *
+ * Entries can be deferred with X-GNOME-Autostart-Delay and classified
+ * with X-Liri-Autostart-Priority (agent, tray or application), otherwise
+ * the GNOME and KDE autostart phases are used to spot agents.
+ */
+class AutostartScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        AgentPriority = 0,
+        TrayPriority,
+        ApplicationPriority
+    };
+    Q_ENUM(Priority)
+
+    explicit AutostartScheduler(ProcessLauncher *launcher, QObject *parent = nullptr);
+
+    int maxConcurrent() const;
+    void setMaxConcurrent(int value);
+
+    bool isStarted() const;
+
+    void schedule(const XdgDesktopFile &entry);
+
+    void startAfterFirstFrame(QQuickWindow *window);
+
+public Q_SLOTS:
+    void start();
+
+private:
+    struct Entry {
+        XdgDesktopFile desktopFile;
+        Priority priority;
+        int delay;
+    };
+
+    ProcessLauncher *m_launcher;
+    QtGSettings::QGSettings *m_settings;
+    int m_maxConcurrent;
+    bool m_started = false;
+    QElapsedTimer m_clock;
+    QMetaObject::Connection m_gateConnection;
+    QTimer *m_gateTimer;
+    QTimer *m_delayTimer;
+    QList<Entry> m_queue;
+    QSet<QString> m_running;
+
+    static Priority priorityForEntry(const XdgDesktopFile &entry);
+
+    void launchNext();
+    void release(const QString &fileName);
+
+private Q_SLOTS:
+    void settingChanged(const QString &key);
+};
+
+#endif // AUTOSTARTSCHEDULER_H
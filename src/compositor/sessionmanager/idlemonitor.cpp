@@ -0,0 +1,254 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+
+#include <Qt5GSettings/QGSettings>
+
+#include "idlemonitor.h"
+#include "sessionmanager.h"
+
+IdleMonitor::IdleMonitor(QObject *parent)
+    : QObject(parent)
+    , m_settings(new QtGSettings::QGSettings(QStringLiteral("io.liri.session"),
+                                             QStringLiteral("/io/liri/session/"),
+                                             this))
+{
+    m_clock.start();
+
+    // Precision doesn't matter here, let the system batch the wake up
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::CoarseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &IdleMonitor::handleTimeout);
+
+    settingChanged(QStringLiteral("idleDelay"));
+    settingChanged(QStringLiteral("blankDelay"));
+    settingChanged(QStringLiteral("lockDelay"));
+    settingChanged(QStringLiteral("suspendDelay"));
+    connect(m_settings, &QtGSettings::QGSettings::settingChanged,
+            this, &IdleMonitor::settingChanged);
+
+    // See all input before it is delivered to windows
+    QCoreApplication::instance()->installEventFilter(this);
+}
+
+IdleMonitor::Stage IdleMonitor::stage() const
+{
+    return m_stage;
+}
+
+qint64 IdleMonitor::idleTime() const
+{
+    return m_clock.elapsed() - m_lastActivity;
+}
+
+qint64 IdleMonitor::stageTime() const
+{
+    return m_clock.elapsed() - m_stageStart;
+}
+
+int IdleMonitor::threshold(Stage stage) const
+{
+    return m_thresholds[stage];
+}
+
+void IdleMonitor::setThreshold(Stage stage, int msecs)
+{
+    if (stage == ActiveStage)
+        return;
+
+    msecs = qMax(0, msecs);
+    if (m_thresholds[stage] == msecs)
+        return;
+
+    m_thresholds[stage] = msecs;
+    rearm();
+}
+
+bool IdleMonitor::isInhibited() const
+{
+    return m_inhibitors > 0 || m_scopedInhibitors > 0;
+}
+
+void IdleMonitor::inhibit(bool scoped)
+{
+    const bool wasInhibited = isInhibited();
+
+    if (scoped)
+        m_scopedInhibitors++;
+    else
+        m_inhibitors++;
+    rearm();
+
+    if (!wasInhibited)
+        Q_EMIT inhibitedChanged(true);
+}
+
+void IdleMonitor::uninhibit(bool scoped)
+{
+    int &count = scoped ? m_scopedInhibitors : m_inhibitors;
+    if (count == 0)
+        return;
+
+    // Count down again from now, not from the last input
+    if (--count == 0 && !scoped)
+        m_countdownStart = m_clock.elapsed();
+    rearm();
+
+    if (!isInhibited())
+        Q_EMIT inhibitedChanged(false);
+}
+
+IdleMonitor::Stage IdleMonitor::maximumStage() const
+{
+    if (m_inhibitors > 0)
+        return ActiveStage;
+    if (m_scopedInhibitors > 0)
+        return BlankStage;
+    return SuspendStage;
+}
+
+void IdleMonitor::reportActivity()
+{
+    m_lastActivity = m_countdownStart = m_clock.elapsed();
+
+    // The timer is left alone while active: it finds out about this
+    // activity when it expires and goes back to sleep for the rest
+    if (m_stage != ActiveStage) {
+        setStage(ActiveStage);
+        rearm();
+    }
+}
+
+bool IdleMonitor::eventFilter(QObject *watched, QEvent *event)
+{
+    // Events are delivered to the window and then again to items,
+    // only look at them once
+    if (!watched->isWindowType())
+        return false;
+
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::TabletPress:
+    case QEvent::TabletMove:
+    case QEvent::TabletRelease:
+        reportActivity();
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+int IdleMonitor::effectiveThreshold(int stage) const
+{
+    if (m_thresholds[stage] == 0)
+        return 0;
+
+    // Settings may be out of order, going to sleep before dimming
+    // for example: hold later stages until the earlier ones passed
+    int msecs = m_thresholds[stage];
+    for (int i = DimStage; i < stage; ++i)
+        msecs = qMax(msecs, m_thresholds[i]);
+    return msecs;
+}
+
+void IdleMonitor::setStage(Stage stage)
+{
+    if (m_stage == stage)
+        return;
+
+    qCDebug(SESSION_MANAGER) << "Idle stage changed from" << m_stage << "to" << stage;
+
+    m_stage = stage;
+    m_stageStart = m_clock.elapsed();
+    Q_EMIT stageChanged(stage);
+}
+
+void IdleMonitor::rearm()
+{
+    m_timer.stop();
+
+    // Find the closest threshold still to come
+    const Stage maxStage = maximumStage();
+    int next = 0;
+    for (int stage = m_stage + 1; stage <= maxStage; ++stage) {
+        const int msecs = effectiveThreshold(stage);
+        if (msecs > 0 && (next == 0 || msecs < next))
+            next = msecs;
+    }
+    if (next == 0)
+        return;
+
+    const qint64 elapsed = m_clock.elapsed() - m_countdownStart;
+    m_timer.start(int(qMax<qint64>(0, next - elapsed)));
+}
+
+void IdleMonitor::handleTimeout()
+{
+    const qint64 elapsed = m_clock.elapsed() - m_countdownStart;
+
+    // Jump to the last stage whose threshold has passed, there might
+    // be more than one if the system was busy or suspended
+    const Stage maxStage = maximumStage();
+    Stage stage = m_stage;
+    for (int i = m_stage + 1; i <= maxStage; ++i) {
+        const int msecs = effectiveThreshold(i);
+        if (msecs > 0 && msecs <= elapsed)
+            stage = static_cast<Stage>(i);
+    }
+    setStage(stage);
+
+    rearm();
+}
+
+void IdleMonitor::settingChanged(const QString &key)
+{
+    Stage stage;
+    if (key == QLatin1String("idleDelay"))
+        stage = DimStage;
+    else if (key == QLatin1String("blankDelay"))
+        stage = BlankStage;
+    else if (key == QLatin1String("lockDelay"))
+        stage = LockStage;
+    else if (key == QLatin1String("suspendDelay"))
+        stage = SuspendStage;
+    else
+        return;
+
+    setThreshold(stage, m_settings->value(key).toInt() * 1000);
+}
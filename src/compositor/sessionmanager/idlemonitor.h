@@ -0,0 +1,115 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef IDLEMONITOR_H
+#define IDLEMONITOR_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+namespace QtGSettings {
+class QGSettings;
+}
+
+/*
+ * Tracks user activity for the whole session.
+ *
+ * Input events are seen by an application event filter that only
+ * records a monotonic timestamp, a single coarse timer wakes up at the
+ * next deadline and moves through the idle stages whose threshold has
+ * passed. Thresholds come from the io.liri.session settings, a zero
+ * threshold disables the stage and a stage is never reached before
+ * the enabled stages that precede it.
+ *
+ * Inhibitors stop the countdown, scoped inhibitors only keep it from
+ * going past the blank stage: outputs are dimmed and blanked where the
+ * inhibiting application is not shown, but the session is never
+ * locked nor suspended.
+ */
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Stage stage READ stage NOTIFY stageChanged)
+    Q_PROPERTY(bool inhibited READ isInhibited NOTIFY inhibitedChanged)
+public:
+    enum Stage {
+        ActiveStage = 0,
+        DimStage,
+        BlankStage,
+        LockStage,
+        SuspendStage
+    };
+    Q_ENUM(Stage)
+
+    explicit IdleMonitor(QObject *parent = nullptr);
+
+    Stage stage() const;
+
+    qint64 idleTime() const;
+    qint64 stageTime() const;
+
+    int threshold(Stage stage) const;
+    void setThreshold(Stage stage, int msecs);
+
+    bool isInhibited() const;
+    void inhibit(bool scoped = false);
+    void uninhibit(bool scoped = false);
+
+    Stage maximumStage() const;
+
+public Q_SLOTS:
+    void reportActivity();
+
+Q_SIGNALS:
+    void stageChanged(IdleMonitor::Stage stage);
+    void inhibitedChanged(bool value);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QtGSettings::QGSettings *m_settings;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    Stage m_stage = ActiveStage;
+    int m_thresholds[SuspendStage + 1] = {};
+    int m_inhibitors = 0;
+    int m_scopedInhibitors = 0;
+    qint64 m_lastActivity = 0;
+    qint64 m_countdownStart = 0;
+    qint64 m_stageStart = 0;
+
+    int effectiveThreshold(int stage) const;
+    void setStage(Stage stage);
+    void rearm();
+
+private Q_SLOTS:
+    void handleTimeout();
+    void settingChanged(const QString &key);
+};
+
+#endif // IDLEMONITOR_H
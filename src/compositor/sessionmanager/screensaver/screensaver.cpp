@@ -26,6 +26,9 @@
 
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusError>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusServiceWatcher>
 
 #include "screensaver.h"
 #include "sessionmanager/sessionmanager.h"
@@ -35,8 +38,36 @@ Q_LOGGING_CATEGORY(SCREENSAVER, "liri.screensaver")
 ScreenSaver::ScreenSaver(QObject *parent)
     : QObject(parent)
     , m_active(false)
+    , m_idle(false)
     , m_sessionManager(qobject_cast<SessionManager *>(parent))
+    , m_serviceWatcher(new QDBusServiceWatcher(this))
+    , m_nextCookie(1)
 {
+    // Release inhibitors of clients that vanish without doing it
+    m_serviceWatcher->setConnection(QDBusConnection::sessionBus());
+    m_serviceWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered,
+            this, &ScreenSaver::serviceUnregistered);
+
+    // The screen saver is active once outputs are blanked
+    connect(m_sessionManager->idleMonitor(), &IdleMonitor::stageChanged, this, [this](IdleMonitor::Stage stage) {
+        // Throttling only matters while the session is idle
+        const bool wasThrottled = isThrottled();
+        m_idle = stage >= IdleMonitor::DimStage;
+        if (isThrottled() != wasThrottled)
+            Q_EMIT throttledChanged();
+
+        bool active = stage >= IdleMonitor::BlankStage;
+        if (m_active == active)
+            return;
+
+        m_active = active;
+        if (m_active)
+            m_activeTime.start();
+        else
+            m_activeTime.invalidate();
+        Q_EMIT ActiveChanged(m_active);
+    });
 }
 
 ScreenSaver::~ScreenSaver()
@@ -60,36 +91,75 @@ bool ScreenSaver::SetActive(bool state)
 
 uint ScreenSaver::GetActiveTime()
 {
-    return 0;
+    // Seconds since the screen saver was activated
+    if (!m_active || !m_activeTime.isValid())
+        return 0;
+    return uint(m_activeTime.elapsed() / 1000);
 }
 
 uint ScreenSaver::GetSessionIdleTime()
 {
-    return 0;
+    // Seconds since the last user input
+    return uint(m_sessionManager->idleMonitor()->idleTime() / 1000);
 }
 
 void ScreenSaver::SimulateUserActivity()
 {
+    m_sessionManager->idleMonitor()->reportActivity();
 }
 
 uint ScreenSaver::Inhibit(const QString &appName, const QString &reason)
 {
-    Q_UNUSED(appName)
-    Q_UNUSED(reason)
+    const Request inhibitor = createRequest(appName, reason);
+    if (!calledFromDBus())
+        return addInhibitor(inhibitor);
 
-    static uint cookieSeed = 0;
-    int newCookie = cookieSeed++;
+    // Reply once the bus told us which process is calling,
+    // without blocking the compositor in the meantime
+    setDelayedReply(true);
+    const QDBusMessage call = message();
+    const QDBusConnection bus = connection();
 
-    Q_EMIT m_sessionManager->idleInhibitRequested();
+    // Watch the caller now, it might leave before we reply
+    m_pendingSenders[inhibitor.sender]++;
+    m_serviceWatcher->addWatchedService(inhibitor.sender);
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.DBus"),
+                                                      QStringLiteral("/org/freedesktop/DBus"),
+                                                      QStringLiteral("org.freedesktop.DBus"),
+                                                      QStringLiteral("GetConnectionUnixProcessID"));
+    msg.setArguments(QVariantList() << inhibitor.sender);
 
-    return newCookie;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(bus.asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, inhibitor, call, bus](QDBusPendingCallWatcher *self) mutable {
+        self->deleteLater();
+
+        // Nobody to reply to if the caller has left the bus
+        auto it = m_pendingSenders.find(inhibitor.sender);
+        if (it == m_pendingSenders.end())
+            return;
+        if (--it.value() == 0)
+            m_pendingSenders.erase(it);
+
+        QDBusPendingReply<uint> reply = *self;
+        if (reply.isValid())
+            inhibitor.pid = reply.value();
+
+        bus.send(call.createReply(addInhibitor(inhibitor)));
+    });
+
+    return 0;
 }
 
 void ScreenSaver::UnInhibit(uint cookie)
 {
-    Q_UNUSED(cookie)
+    if (!isRequestOwner(m_inhibitors, cookie))
+        return;
 
-    Q_EMIT m_sessionManager->idleUninhibitRequested();
+    qCDebug(SCREENSAVER) << "Uninhibit" << cookie << "by" << m_inhibitors.value(cookie).appName;
+
+    removeInhibitor(cookie);
 }
 
 void ScreenSaver::Lock()
@@ -99,16 +169,232 @@ void ScreenSaver::Lock()
 
 uint ScreenSaver::Throttle(const QString &appName, const QString &reason)
 {
-    // TODO:
-    Q_UNUSED(appName);
-    Q_UNUSED(reason);
-    return 0;
+    const Request throttle = createRequest(appName, reason);
+    const uint cookie = addRequest(m_throttles, throttle);
+
+    qCDebug(SCREENSAVER) << "Throttle" << cookie << "by" << appName << throttle.sender
+                         << "reason" << reason;
+
+    if (m_idle && m_throttles.size() == 1)
+        Q_EMIT throttledChanged();
+
+    return cookie;
 }
 
 void ScreenSaver::UnThrottle(uint cookie)
 {
-    // TODO:
-    Q_UNUSED(cookie);
+    if (!isRequestOwner(m_throttles, cookie))
+        return;
+
+    qCDebug(SCREENSAVER) << "Unthrottle" << cookie << "by" << m_throttles.value(cookie).appName;
+
+    removeThrottle(cookie);
+}
+
+QVariantList ScreenSaver::inhibitors() const
+{
+    QVariantList list;
+
+    for (auto it = m_inhibitors.constBegin(); it != m_inhibitors.constEnd(); ++it)
+        list.append(requestToMap(it.key(), it.value()));
+
+    return list;
+}
+
+QVariantList ScreenSaver::inhibitorsForApplication(const QString &appName) const
+{
+    QVariantList list;
+
+    for (auto it = m_inhibitors.constBegin(); it != m_inhibitors.constEnd(); ++it) {
+        if (it->appName == appName)
+            list.append(requestToMap(it.key(), it.value()));
+    }
+
+    return list;
+}
+
+bool ScreenSaver::isThrottled() const
+{
+    // Like a screen saver, throttling kicks in once the session is idle
+    // and only outputs kept awake by an inhibitor are affected, the
+    // others are capped harder because they are dimmed
+    return m_idle && !m_throttles.isEmpty();
+}
+
+QVariantList ScreenSaver::windowedProcesses() const
+{
+    QVariantList list;
+    for (qint64 pid : qAsConst(m_windowedProcesses))
+        list.append(pid);
+    return list;
+}
+
+void ScreenSaver::setWindowedProcesses(const QVariantList &processes)
+{
+    QSet<qint64> pids;
+    for (const QVariant &pid : processes)
+        pids.insert(pid.toLongLong());
+
+    if (m_windowedProcesses == pids)
+        return;
+
+    m_windowedProcesses = pids;
+    Q_EMIT windowedProcessesChanged();
+
+    updateScopes();
+}
+
+ScreenSaver::Request ScreenSaver::createRequest(const QString &appName, const QString &reason) const
+{
+    Request request;
+    request.appName = appName;
+    request.reason = reason;
+    request.pid = 0;
+    request.scoped = false;
+
+    if (calledFromDBus())
+        request.sender = message().service();
+
+    return request;
+}
+
+uint ScreenSaver::addRequest(QHash<uint, Request> &requests, const Request &request)
+{
+    // Never hand out 0 and don't reuse cookies still in use
+    while (m_nextCookie == 0 || m_inhibitors.contains(m_nextCookie) || m_throttles.contains(m_nextCookie))
+        m_nextCookie++;
+    const uint cookie = m_nextCookie++;
+
+    requests.insert(cookie, request);
+    if (!request.sender.isEmpty()) {
+        if (!m_cookiesBySender.contains(request.sender))
+            m_serviceWatcher->addWatchedService(request.sender);
+        m_cookiesBySender.insert(request.sender, cookie);
+    }
+
+    return cookie;
+}
+
+uint ScreenSaver::addInhibitor(Request inhibitor)
+{
+    inhibitor.scoped = isScoped(inhibitor);
+    const uint cookie = addRequest(m_inhibitors, inhibitor);
+
+    qCDebug(SCREENSAVER) << "Inhibit" << cookie << "by" << inhibitor.appName << inhibitor.sender
+                         << "pid" << inhibitor.pid << "scoped" << inhibitor.scoped
+                         << "reason" << inhibitor.reason;
+
+    m_sessionManager->idleMonitor()->inhibit(inhibitor.scoped);
+    Q_EMIT m_sessionManager->idleInhibitRequested();
+    Q_EMIT inhibitorsChanged();
+
+    return cookie;
+}
+
+bool ScreenSaver::isScoped(const Request &inhibitor) const
+{
+    // When the process has windows only the outputs showing them are
+    // kept awake, otherwise the whole session is kept from idling
+    return inhibitor.pid > 0 && m_windowedProcesses.contains(inhibitor.pid);
+}
+
+void ScreenSaver::updateScopes()
+{
+    bool changed = false;
+
+    for (auto it = m_inhibitors.begin(); it != m_inhibitors.end(); ++it) {
+        const bool scoped = isScoped(it.value());
+        if (it->scoped == scoped)
+            continue;
+
+        // Take the new scope before dropping the old one, so that
+        // the session is never seen as uninhibited in between
+        it->scoped = scoped;
+        m_sessionManager->idleMonitor()->inhibit(scoped);
+        m_sessionManager->idleMonitor()->uninhibit(!scoped);
+        changed = true;
+    }
+
+    if (changed)
+        Q_EMIT inhibitorsChanged();
+}
+
+bool ScreenSaver::isRequestOwner(const QHash<uint, Request> &requests, uint cookie) const
+{
+    auto it = requests.constFind(cookie);
+    if (it == requests.constEnd()) {
+        qCWarning(SCREENSAVER, "Unknown cookie %u", cookie);
+        return false;
+    }
+
+    if (calledFromDBus() && it->sender != message().service()) {
+        qCWarning(SCREENSAVER, "Refusing to release cookie %u of %s on behalf of %s",
+                  cookie, qPrintable(it->sender), qPrintable(message().service()));
+        return false;
+    }
+
+    return true;
+}
+
+void ScreenSaver::releaseSender(const QString &sender, uint cookie)
+{
+    if (sender.isEmpty())
+        return;
+
+    m_cookiesBySender.remove(sender, cookie);
+    if (!m_cookiesBySender.contains(sender) && !m_pendingSenders.contains(sender))
+        m_serviceWatcher->removeWatchedService(sender);
+}
+
+QVariantMap ScreenSaver::requestToMap(uint cookie, const Request &request)
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("cookie"), cookie);
+    map.insert(QStringLiteral("appName"), request.appName);
+    map.insert(QStringLiteral("reason"), request.reason);
+    map.insert(QStringLiteral("sender"), request.sender);
+    map.insert(QStringLiteral("pid"), request.pid);
+    map.insert(QStringLiteral("scoped"), request.scoped);
+    return map;
+}
+
+void ScreenSaver::removeInhibitor(uint cookie)
+{
+    const Request inhibitor = m_inhibitors.take(cookie);
+    releaseSender(inhibitor.sender, cookie);
+
+    m_sessionManager->idleMonitor()->uninhibit(inhibitor.scoped);
+    Q_EMIT m_sessionManager->idleUninhibitRequested();
+    Q_EMIT inhibitorsChanged();
+}
+
+void ScreenSaver::removeThrottle(uint cookie)
+{
+    const Request throttle = m_throttles.take(cookie);
+    releaseSender(throttle.sender, cookie);
+
+    if (m_idle && m_throttles.isEmpty())
+        Q_EMIT throttledChanged();
+}
+
+void ScreenSaver::serviceUnregistered(const QString &service)
+{
+    const QList<uint> cookies = m_cookiesBySender.values(service);
+    for (uint cookie : cookies) {
+        if (m_inhibitors.contains(cookie)) {
+            qCInfo(SCREENSAVER, "Releasing inhibitor %u of %s, %s has left the bus",
+                   cookie, qPrintable(m_inhibitors.value(cookie).appName), qPrintable(service));
+            removeInhibitor(cookie);
+        } else if (m_throttles.contains(cookie)) {
+            qCInfo(SCREENSAVER, "Releasing throttle %u of %s, %s has left the bus",
+                   cookie, qPrintable(m_throttles.value(cookie).appName), qPrintable(service));
+            removeThrottle(cookie);
+        }
+    }
+
+    // Inhibitors still waiting for their process are dropped too
+    m_pendingSenders.remove(service);
+    m_serviceWatcher->removeWatchedService(service);
 }
 
 #include "moc_screensaver.cpp"
@@ -27,16 +27,26 @@
 #ifndef SCREENSAVER_H
 #define SCREENSAVER_H
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QVariant>
+#include <QtDBus/QDBusContext>
 
 Q_DECLARE_LOGGING_CATEGORY(SCREENSAVER)
 
+class QDBusServiceWatcher;
+
 class SessionManager;
 
-class ScreenSaver : public QObject
+class ScreenSaver : public QObject, protected QDBusContext
 {
     Q_OBJECT
+    Q_PROPERTY(QVariantList inhibitors READ inhibitors NOTIFY inhibitorsChanged)
+    Q_PROPERTY(bool throttled READ isThrottled NOTIFY throttledChanged)
+    Q_PROPERTY(QVariantList windowedProcesses READ windowedProcesses WRITE setWindowedProcesses NOTIFY windowedProcessesChanged)
 public:
     ScreenSaver(QObject *parent = nullptr);
     ~ScreenSaver();
@@ -57,12 +67,55 @@ public:
     uint Throttle(const QString &appName, const QString &reason);
     void UnThrottle(uint cookie);
 
+    QVariantList inhibitors() const;
+    Q_INVOKABLE QVariantList inhibitorsForApplication(const QString &appName) const;
+
+    bool isThrottled() const;
+
+    QVariantList windowedProcesses() const;
+    void setWindowedProcesses(const QVariantList &processes);
+
 Q_SIGNALS:
     void ActiveChanged(bool in);
+    void inhibitorsChanged();
+    void throttledChanged();
+    void windowedProcessesChanged();
 
 private:
+    struct Request {
+        QString sender;
+        QString appName;
+        QString reason;
+        qint64 pid;
+        bool scoped;
+    };
+
     bool m_active;
+    bool m_idle;
+    QElapsedTimer m_activeTime;
     SessionManager *m_sessionManager;
+    QDBusServiceWatcher *m_serviceWatcher;
+    uint m_nextCookie;
+    QHash<uint, Request> m_inhibitors;
+    QHash<uint, Request> m_throttles;
+    QMultiHash<QString, uint> m_cookiesBySender;
+    QHash<QString, int> m_pendingSenders;
+    QSet<qint64> m_windowedProcesses;
+
+    static QVariantMap requestToMap(uint cookie, const Request &request);
+
+    Request createRequest(const QString &appName, const QString &reason) const;
+    uint addRequest(QHash<uint, Request> &requests, const Request &request);
+    uint addInhibitor(Request inhibitor);
+    bool isScoped(const Request &inhibitor) const;
+    void updateScopes();
+    bool isRequestOwner(const QHash<uint, Request> &requests, uint cookie) const;
+    void releaseSender(const QString &sender, uint cookie);
+    void removeInhibitor(uint cookie);
+    void removeThrottle(uint cookie);
+
+private Q_SLOTS:
+    void serviceUnregistered(const QString &service);
 };
 
 #endif // SCREENSAVER_H
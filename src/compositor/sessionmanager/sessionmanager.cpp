@@ -51,6 +51,7 @@ SessionManager::SessionManager(QObject *parent)
     , m_authRequested(false)
     , m_authenticator(new Authenticator)
     , m_loginManager(new LoginManager(this, this))
+    , m_idleMonitor(new IdleMonitor(this))
     , m_screenSaver(new ScreenSaver(this))
     , m_idle(false)
     , m_locked(false)
@@ -59,6 +60,13 @@ SessionManager::SessionManager(QObject *parent)
     connect(m_loginManager, &LoginManager::sessionLocked, this, [this] { setLocked(true); });
     connect(m_loginManager, &LoginManager::sessionUnlocked, this, [this] { setLocked(false); });
 
+    // Idle hint and automatic lock
+    connect(m_idleMonitor, &IdleMonitor::stageChanged, this, [this](IdleMonitor::Stage stage) {
+        setIdle(stage != IdleMonitor::ActiveStage);
+        if (stage == IdleMonitor::LockStage)
+            lockSession();
+    });
+
     // Logout session before the system goes off
     connect(m_loginManager, &LoginManager::logOutRequested, this, &SessionManager::logOut);
 
@@ -104,6 +112,16 @@ void SessionManager::setIdle(bool value)
     Q_EMIT idleChanged(value);
 }
 
+IdleMonitor *SessionManager::idleMonitor() const
+{
+    return m_idleMonitor;
+}
+
+ScreenSaver *SessionManager::screenSaver() const
+{
+    return m_screenSaver;
+}
+
 bool SessionManager::isLocked() const
 {
     return m_locked;
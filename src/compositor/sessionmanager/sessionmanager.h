@@ -32,17 +32,21 @@
 #include <QtCore/QThread>
 #include <QtQml/QJSValue>
 
+#include "sessionmanager/idlemonitor.h"
+#include "sessionmanager/screensaver/screensaver.h"
+
 Q_DECLARE_LOGGING_CATEGORY(SESSION_MANAGER)
 
 class Authenticator;
 class CustomAuthenticator;
 class LoginManager;
-class ScreenSaver;
 
 class SessionManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool idle READ isIdle WRITE setIdle NOTIFY idleChanged)
+    Q_PROPERTY(IdleMonitor *idleMonitor READ idleMonitor CONSTANT)
+    Q_PROPERTY(ScreenSaver *screenSaver READ screenSaver CONSTANT)
     Q_PROPERTY(bool locked READ isLocked NOTIFY lockedChanged)
     Q_PROPERTY(bool canLock READ canLock CONSTANT)
     Q_PROPERTY(bool canStartNewSession READ canStartNewSession CONSTANT)
@@ -56,6 +60,9 @@ public:
     bool isIdle() const;
     void setIdle(bool value);
 
+    IdleMonitor *idleMonitor() const;
+    ScreenSaver *screenSaver() const;
+
     bool isLocked() const;
 
     bool canLock() const;
@@ -104,6 +111,7 @@ private:
     Authenticator *m_authenticator;
 
     LoginManager *m_loginManager;
+    IdleMonitor *m_idleMonitor;
     ScreenSaver *m_screenSaver;
     QList<qint64> m_processes;
 
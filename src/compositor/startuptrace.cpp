@@ -0,0 +1,216 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+#include <QtGui/QPlatformSurfaceEvent>
+#include <QtGui/QScreen>
+#include <QtQuick/QQuickWindow>
+
+#include "logging_p.h"
+#include "startuptrace.h"
+
+struct StartupTraceData
+{
+    QMutex mutex;
+    QString fileName;
+    QElapsedTimer clock;
+    QJsonArray events;
+};
+
+Q_GLOBAL_STATIC(StartupTraceData, s_trace)
+
+static QAtomicInt s_enabled;
+
+/*
+ * Watches every window being created, including outputs added
+ * after the compositor was loaded.
+ */
+class WindowWatcher : public QObject
+{
+public:
+    bool eventFilter(QObject *object, QEvent *event) override
+    {
+        if (event->type() == QEvent::PlatformSurface &&
+                static_cast<QPlatformSurfaceEvent *>(event)->surfaceEventType() ==
+                QPlatformSurfaceEvent::SurfaceCreated) {
+            QQuickWindow *window = qobject_cast<QQuickWindow *>(object);
+            if (window && !m_windows.contains(window)) {
+                m_windows.insert(window);
+                connect(window, &QObject::destroyed, this, [this, window] {
+                    m_windows.remove(window);
+                });
+                StartupTrace::watchFirstFrame(window);
+            }
+        }
+
+        return QObject::eventFilter(object, event);
+    }
+
+private:
+    QSet<QQuickWindow *> m_windows;
+};
+
+static void record(const QString &name, const char *phase, qint64 timestamp = -1,
+                   qint64 duration = -1)
+{
+    if (!s_enabled.load())
+        return;
+
+    QMutexLocker locker(&s_trace->mutex);
+
+    if (timestamp < 0)
+        timestamp = s_trace->clock.nsecsElapsed() / 1000;
+
+    QJsonObject event;
+    event.insert(QStringLiteral("name"), name);
+    event.insert(QStringLiteral("cat"), QStringLiteral("startup"));
+    event.insert(QStringLiteral("ph"), QLatin1String(phase));
+    event.insert(QStringLiteral("ts"), double(timestamp));
+    if (duration >= 0)
+        event.insert(QStringLiteral("dur"), double(duration));
+    event.insert(QStringLiteral("pid"), double(QCoreApplication::applicationPid()));
+    event.insert(QStringLiteral("tid"), double(quintptr(QThread::currentThreadId())));
+    if (phase[0] == 'i')
+        event.insert(QStringLiteral("s"), QStringLiteral("p"));
+    s_trace->events.append(event);
+}
+
+bool StartupTrace::isEnabled()
+{
+    return s_enabled.load();
+}
+
+QString StartupTrace::fileName()
+{
+    QMutexLocker locker(&s_trace->mutex);
+    return s_trace->fileName;
+}
+
+void StartupTrace::setFileName(const QString &fileName)
+{
+    QMutexLocker locker(&s_trace->mutex);
+
+    s_trace->fileName = fileName;
+    if (!s_trace->clock.isValid())
+        s_trace->clock.start();
+    s_enabled.store(!fileName.isEmpty());
+}
+
+qint64 StartupTrace::timestamp()
+{
+    if (!s_enabled.load())
+        return -1;
+
+    QMutexLocker locker(&s_trace->mutex);
+    return s_trace->clock.nsecsElapsed() / 1000;
+}
+
+void StartupTrace::begin(const char *name)
+{
+    record(QLatin1String(name), "B");
+}
+
+void StartupTrace::end(const char *name)
+{
+    record(QLatin1String(name), "E");
+}
+
+void StartupTrace::complete(const QString &name, qint64 beginTimestamp)
+{
+    // Tracing was enabled while the span was open
+    if (beginTimestamp < 0)
+        return;
+
+    record(name, "X", beginTimestamp, timestamp() - beginTimestamp);
+}
+
+void StartupTrace::instant(const QString &name)
+{
+    record(name, "i");
+}
+
+void StartupTrace::watchFirstFrame(QQuickWindow *window)
+{
+    if (!s_enabled.load() || !window)
+        return;
+
+    const QString name = QStringLiteral("First frame on %1").arg(
+                window->screen() ? window->screen()->name() : window->title());
+
+    // Swaps come from the render thread, save from the GUI thread;
+    // the handle goes away with the slot, even if the window is
+    // destroyed before its first frame
+    QSharedPointer<QMetaObject::Connection> connection(new QMetaObject::Connection);
+    *connection = QObject::connect(window, &QQuickWindow::frameSwapped, window, [name, connection] {
+        QObject::disconnect(*connection);
+
+        instant(name);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [] { save(); },
+                                  Qt::QueuedConnection);
+    }, Qt::DirectConnection);
+}
+
+void StartupTrace::watchWindows()
+{
+    static WindowWatcher *watcher = nullptr;
+    if (!s_enabled.load() || watcher)
+        return;
+
+    watcher = new WindowWatcher;
+    watcher->setParent(QCoreApplication::instance());
+    QCoreApplication::instance()->installEventFilter(watcher);
+}
+
+bool StartupTrace::save()
+{
+    if (!s_enabled.load())
+        return false;
+
+    QMutexLocker locker(&s_trace->mutex);
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), s_trace->events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QSaveFile file(s_trace->fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcShell, "Unable to write startup trace to \"%s\": %s",
+                  qPrintable(s_trace->fileName), qPrintable(file.errorString()));
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QString>
+
+QT_FORWARD_DECLARE_CLASS(QQuickWindow)
+
+/*
+ * Opt-in trace of the startup sequence.
+ *
+ * Spans and events are recorded against a monotonic clock once a file
+ * name is set, and saved in the Chrome trace event format that can be
+ * loaded with chrome://tracing or Perfetto.
+ * Recording is thread-safe, first frames are swapped on the render thread.
+ * QML components are traced with the StartupSpan type.
+ */
+class StartupTrace
+{
+public:
+    static bool isEnabled();
+
+    static QString fileName();
+    static void setFileName(const QString &fileName);
+
+    static qint64 timestamp();
+
+    static void begin(const char *name);
+    static void end(const char *name);
+    static void complete(const QString &name, qint64 beginTimestamp);
+    static void instant(const QString &name);
+
+    static void watchFirstFrame(QQuickWindow *window);
+    static void watchWindows();
+
+    static bool save();
+};
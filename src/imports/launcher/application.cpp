@@ -20,15 +20,20 @@
 
 #include "application.h"
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
 #include <QtCore/QLocale>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
 #include <QtDBus/QDBusConnection>
-#include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
 #include <QtWaylandCompositor/QWaylandClient>
 
 #include "applicationmanager.h"
+#include "launchstatistics.h"
+#include "processlauncherproperty.h"
 
 // Applications have 5 seconds to start up before the start animation ends
 #define MAX_APPLICATION_STARTUP_TIME (5 * 1000)
@@ -38,9 +43,45 @@ Application::Application(const QString &appId, const QStringList &categories, QO
     , m_appId(appId)
     , m_categories(categories)
 {
-    m_desktopFile = new DesktopFile(appId, this);
+}
+
+QString Application::name() const
+{
+    if (!m_desktopFile && m_hasCachedEntry)
+        return m_cachedName;
+    return desktopFile()->name();
+}
+
+QString Application::genericName() const
+{
+    if (!m_desktopFile && m_hasCachedEntry)
+        return m_cachedGenericName;
+    return desktopFile()->genericName();
+}
+
+QString Application::comment() const
+{
+    if (!m_desktopFile && m_hasCachedEntry)
+        return m_cachedComment;
+    return desktopFile()->comment();
+}
 
-    connect(m_desktopFile, &DesktopFile::dataChanged, this, &Application::dataChanged);
+QString Application::iconName() const
+{
+    if (!m_desktopFile && m_hasCachedEntry)
+        return m_cachedIconName;
+    return desktopFile()->iconName();
+}
+
+DesktopFile *Application::desktopFile() const
+{
+    if (!m_desktopFile) {
+        Application *self = const_cast<Application *>(this);
+        m_desktopFile = new DesktopFile(m_appId, self);
+        connect(m_desktopFile, &DesktopFile::dataChanged, self, &Application::dataChanged);
+    }
+
+    return m_desktopFile;
 }
 
 bool Application::hasCategory(const QString &category) const
@@ -81,10 +122,10 @@ void Application::setActive(bool active)
 QQmlListProperty<DesktopFileAction> Application::actions()
 {
     auto countFunc = [](QQmlListProperty<DesktopFileAction> *prop) {
-        return static_cast<Application *>(prop->object)->m_desktopFile->actions().count();
+        return static_cast<Application *>(prop->object)->desktopFile()->actions().count();
     };
     auto atFunc = [](QQmlListProperty<DesktopFileAction> *prop, int i) {
-        return static_cast<Application *>(prop->object)->m_desktopFile->actions().at(i);
+        return static_cast<Application *>(prop->object)->desktopFile()->actions().at(i);
     };
     return QQmlListProperty<DesktopFileAction>(this, nullptr, countFunc, atFunc);
 }
@@ -93,32 +134,72 @@ bool Application::launch(const QStringList &urls)
 {
     Q_UNUSED(urls);
 
-    if (!m_desktopFile->isValid())
+    if (!desktopFile()->isValid())
         return false;
 
     if (isRunning())
         return true;
 
+    // Give feedback right away, the spawn itself may take a while
+    setState(Application::Starting);
+    LaunchStatistics::instance()->launchStarted(m_appId);
+
     // TODO: Send urls to process launcher
-    const QDBusConnection bus = QDBusConnection::sessionBus();
-    QDBusInterface interface(QStringLiteral("io.liri.Session"),
-                             QStringLiteral("/ProcessLauncher"),
-                             QStringLiteral("io.liri.ProcessLauncher"), bus);
-    QDBusMessage msg = interface.call(QStringLiteral("launchDesktopFile"), m_desktopFile->path());
-    bool ran = msg.arguments().at(0).toBool();
-
-    if (ran) {
-        setState(Application::Starting);
-
-        QTimer::singleShot(MAX_APPLICATION_STARTUP_TIME, [=]() {
-            if (isStarting())
-                setState(Application::NotRunning);
-        });
-
-        Q_EMIT launched();
+    const QString fileName = desktopFile()->path();
+
+    // When we live inside the compositor process the launcher is right
+    // there, otherwise ask the session over D-Bus without blocking
+    QObject *launcher = processLauncher();
+    if (launcher) {
+        bool ran = false;
+        QMetaObject::invokeMethod(launcher, "launchDesktopFile", Qt::DirectConnection,
+                                  Q_RETURN_ARG(bool, ran), Q_ARG(QString, fileName));
+        launchFinished(ran);
+        return ran;
     }
 
-    return ran;
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("io.liri.Session"),
+                                                      QStringLiteral("/ProcessLauncher"),
+                                                      QStringLiteral("io.liri.ProcessLauncher"),
+                                                      QStringLiteral("launchDesktopFile"));
+    msg.setArguments(QVariantList() << fileName);
+
+    QDBusPendingCallWatcher *watcher =
+            new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *self) {
+        QDBusPendingReply<bool> reply = *self;
+        if (reply.isError())
+            qCWarning(APPLICATION_MANAGER, "Failed to launch \"%s\": %s",
+                      qPrintable(m_appId), qPrintable(reply.error().message()));
+        launchFinished(!reply.isError() && reply.value());
+        self->deleteLater();
+    });
+
+    return true;
+}
+
+QObject *Application::processLauncher()
+{
+    return QCoreApplication::instance()->property(PROCESS_LAUNCHER_PROPERTY).value<QObject *>();
+}
+
+void Application::launchFinished(bool ran)
+{
+    if (!ran) {
+        LaunchStatistics::instance()->launchFailed(m_appId);
+        if (isStarting())
+            setState(Application::NotRunning);
+        return;
+    }
+
+    LaunchStatistics::instance()->launchSpawned(m_appId);
+
+    QTimer::singleShot(MAX_APPLICATION_STARTUP_TIME, this, [this]() {
+        if (isStarting())
+            setState(Application::NotRunning);
+    });
+
+    Q_EMIT launched();
 }
 
 bool Application::quit()
@@ -135,6 +216,16 @@ bool Application::quit()
     return true;
 }
 
+void Application::setCachedEntry(const QString &name, const QString &genericName,
+                                 const QString &comment, const QString &iconName)
+{
+    m_hasCachedEntry = true;
+    m_cachedName = name;
+    m_cachedGenericName = genericName;
+    m_cachedComment = comment;
+    m_cachedIconName = iconName;
+}
+
 void Application::addClient(QWaylandClient *client)
 {
     auto it = std::find_if(m_clients.begin(), m_clients.end(), [client](const QWaylandClient *item) {
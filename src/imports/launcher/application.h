@@ -84,14 +84,14 @@ public:
 
     explicit Application(const QString &appId, const QStringList &categories, QObject *parent = nullptr);
 
-    bool isValid() const { return m_desktopFile != nullptr && m_desktopFile->isValid(); }
+    bool isValid() const { return desktopFile()->isValid(); }
 
     bool hasCategory(const QString &category) const;
 
-    QString name() const { return m_desktopFile->name(); }
-    QString genericName() const { return m_desktopFile->genericName(); }
-    QString comment() const { return m_desktopFile->comment(); }
-    QString iconName() const { return m_desktopFile->iconName(); }
+    QString name() const;
+    QString genericName() const;
+    QString comment() const;
+    QString iconName() const;
     QStringList categories() const { return m_categories; }
 
     /*!
@@ -113,8 +113,9 @@ public:
      * \brief Desktop entry file name.
      *
      * Returns the desktop entry file name.
+     * The entry is loaded the first time it's needed.
      */
-    DesktopFile *desktopFile() const { return m_desktopFile; }
+    DesktopFile *desktopFile() const;
 
     /*!
      * \brief Application active state.
@@ -161,7 +162,12 @@ protected:
 private:
     QString m_appId;
     QStringList m_categories;
-    DesktopFile *m_desktopFile = nullptr;
+    mutable DesktopFile *m_desktopFile = nullptr;
+    bool m_hasCachedEntry = false;
+    QString m_cachedName;
+    QString m_cachedGenericName;
+    QString m_cachedComment;
+    QString m_cachedIconName;
     bool m_active = false;
     bool m_pinned = false;
     int m_count = 0;
@@ -169,6 +175,11 @@ private:
     State m_state = NotRunning;
 
     void addClient(QWaylandClient *client);
+    void launchFinished(bool ran);
+    void setCachedEntry(const QString &name, const QString &genericName,
+                        const QString &comment, const QString &iconName);
+
+    static QObject *processLauncher();
 };
 
 QML_DECLARE_TYPE(DesktopFileAction)
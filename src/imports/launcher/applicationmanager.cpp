@@ -22,22 +22,17 @@
  * $END_LICENSE$
  ***************************************************************************/
 
-#include <QtCore/QFileInfo>
-#include <QtCore/QFileSystemWatcher>
-#include <QtCore/QFuture>
 #include <QtCore/QThread>
-#include <QtConcurrent/QtConcurrentRun>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusInterface>
-#include <QtGui/QIcon>
 #include <QtWaylandCompositor/QWaylandSurface>
-#include <qt5xdg/xdgmenu.h>
-#include <qt5xdg/xmlhelper.h>
 
 #include "application.h"
 #include "applicationmanager.h"
+#include "iconcache.h"
+#include "launchstatistics.h"
+#include "menuindex.h"
 #include "usagetracker.h"
-#include "utils.h"
 
 Q_LOGGING_CATEGORY(APPLICATION_MANAGER, "liri.launcher.applicationmanager")
 
@@ -46,14 +41,51 @@ ApplicationManager::ApplicationManager(QObject *parent)
 {
     m_settings = new QGSettings(QStringLiteral("io.liri.desktop.panel"),
                                 QStringLiteral("/io/liri/desktop/panel/"), this);
+    m_pinnedLaunchers = m_settings->value(QStringLiteral("pinnedLaunchers")).toStringList();
+    connect(m_settings, &QGSettings::settingChanged, this, &ApplicationManager::handleSettingChanged);
 
-    QtConcurrent::run(ApplicationManager::refresh, this);
+    connect(UsageTracker::instance(), &UsageTracker::ranksChanged, this, [this](const QStringList &appIds) {
+        const int slot = roleSlot(UsageRankRole);
+        for (const QString &appId : appIds) {
+            int i = m_appIdToRow.value(appId, -1);
+            if (i < 0)
+                continue;
 
-    QFileSystemWatcher *watcher = new QFileSystemWatcher(this);
-    watcher->addPaths(xdgApplicationsPaths());
-    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &) {
-        QtConcurrent::run(ApplicationManager::refresh, this);
+            m_roleCache[i][slot] = UsageTracker::instance()->rankForAppId(appId);
+
+            QModelIndex modelIndex = index(i);
+            QVector<int> roles;
+            roles.append(ApplicationManager::UsageRankRole);
+            Q_EMIT dataChanged(modelIndex, modelIndex, roles);
+        }
     });
+
+    connect(IconCache::instance(), &IconCache::themeChanged, this, [this] {
+        if (m_apps.isEmpty())
+            return;
+
+        const int slot = roleSlot(Qt::DecorationRole);
+        for (int i = 0; i < m_apps.size(); i++)
+            m_roleCache[i][slot] = IconCache::instance()->iconUrl(m_apps.at(i)->iconName());
+
+        QVector<int> roles;
+        roles.append(Qt::DecorationRole);
+        Q_EMIT dataChanged(index(0), index(m_apps.size() - 1), roles);
+    });
+
+    // Start from the current menu and follow its changes
+    MenuIndex *menuIndex = MenuIndex::instance();
+    const MenuSnapshot snapshot = menuIndex->snapshot();
+    for (const MenuCacheApplication &entry : snapshot->applications)
+        addApp(entry);
+    connect(menuIndex, &MenuIndex::applicationAdded, this, &ApplicationManager::addApp);
+    connect(menuIndex, &MenuIndex::applicationChanged, this, &ApplicationManager::updateApp);
+    connect(menuIndex, &MenuIndex::applicationRemoved, this, [this](const QString &appId) {
+        Application *app = findApplication(appId);
+        if (app)
+            removeApp(app);
+    });
+    connect(menuIndex, &MenuIndex::refreshed, this, &ApplicationManager::refreshed);
 }
 
 ApplicationManager::~ApplicationManager()
@@ -86,6 +118,7 @@ QHash<int, QByteArray> ApplicationManager::roleNames() const
     roles.insert(CountRole, "count");
     roles.insert(HasProgressRole, "hasProgress");
     roles.insert(ProgressRole, "progress");
+    roles.insert(UsageRankRole, "usageRank");
     return roles;
 }
 
@@ -97,86 +130,57 @@ int ApplicationManager::rowCount(const QModelIndex &parent) const
 
 QVariant ApplicationManager::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid())
-        return QVariant();
-
-    Application *app = m_apps.at(index.row());
-    if (!app)
+    if (!index.isValid() || index.row() >= m_roleCache.size())
         return QVariant();
 
-    QStringList pinnedApps =
-            m_settings->value(QStringLiteral("pinnedLaunchers")).toStringList();
-    int pinnedIndex = pinnedApps.indexOf(app->appId());
+    // Desktop entries are loaded on demand
+    if (role == DesktopFileRole)
+        return qVariantFromValue(m_apps.at(index.row())->desktopFile());
 
-    switch (role) {
-    case Qt::DecorationRole:
-        return QIcon::fromTheme(app->iconName());
-    case Qt::DisplayRole:
-    case NameRole:
-        return app->name();
-    case DesktopFileRole:
-        return qVariantFromValue(app->desktopFile());
-    case ApplicationRole:
-        return qVariantFromValue(app);
-    case AppIdRole:
-        return app->appId();
-    case GenericNameRole:
-        return app->genericName();
-    case CommentRole:
-        return app->comment();
-    case IconNameRole:
-        return app->iconName();
-    case CategoriesRole:
-        return app->categories();
-    case FilterInfoRole:
-        return QString(app->name() + QStringLiteral(" ") + app->genericName() + QStringLiteral(" ") + app->comment());
-    case PinnedRole:
-        return app->isPinned();
-    case PinnedIndexRole:
-        return pinnedIndex;
-    case RunningRole:
-        return app->isRunning();
-    case StartingRole:
-        return app->isStarting();
-    case ActiveRole:
-        return app->isActive();
-    case HasWindowsRole:
-        return false;
-    case HasCountRole:
-        return app->count() > 0;
-    case CountRole:
-        return app->count();
-    case HasProgressRole:
-        return app->progress() >= 0;
-    case ProgressRole:
-        return app->progress();
-    default:
-        break;
-    }
+    int slot = roleSlot(role);
+    if (slot < 0)
+        return QVariant();
 
-    return QVariant();
+    return m_roleCache.at(index.row()).at(slot);
 }
 
 Application *ApplicationManager::findApplication(const QString &appId)
 {
-    for (Application *app : qAsConst(m_apps)) {
-        if (app->appId() == appId)
-            return app;
-    }
-    return nullptr;
+    int row = m_appIdToRow.value(appId, -1);
+    return row >= 0 ? m_apps.at(row) : nullptr;
 }
 
 Application *ApplicationManager::newApplication(const QString &appId)
 {
-    Application *app = new Application(appId, QStringList(), this);
+    return setupApplication(new Application(appId, QStringList(), this));
+}
+
+Application *ApplicationManager::setupApplication(Application *app)
+{
+    const QString appId = app->appId();
+
     app->moveToThread(thread());
 
     m_apps.append(app);
+    m_appIdToRow.insert(appId, m_apps.size() - 1);
+    m_appToRow.insert(app, m_apps.size() - 1);
+    m_roleCache.append(QVector<QVariant>());
+    updateRoleCache(m_apps.size() - 1);
+
+    connect(app, &Application::dataChanged, this, [this, app] {
+        int i = rowForApplication(app);
 
+        if (i >= 0) {
+            updateRoleCache(i);
+            QModelIndex modelIndex = index(i);
+            Q_EMIT dataChanged(modelIndex, modelIndex);
+        }
+    });
     connect(app, &Application::activeChanged, this, [this, app] {
-        int i = m_apps.indexOf(app);
+        int i = rowForApplication(app);
 
         if (i >= 0) {
+            updateRoleCache(i);
             QModelIndex modelIndex = index(i);
             QVector<int> roles;
             roles.append(ApplicationManager::ActiveRole);
@@ -184,9 +188,10 @@ Application *ApplicationManager::newApplication(const QString &appId)
         }
     });
     connect(app, &Application::stateChanged, this, [this, app] {
-        int i = m_apps.indexOf(app);
+        int i = rowForApplication(app);
 
         if (i >= 0) {
+            updateRoleCache(i);
             QModelIndex modelIndex = index(i);
             QVector<int> roles;
             roles.append(ApplicationManager::ActiveRole);
@@ -195,13 +200,36 @@ Application *ApplicationManager::newApplication(const QString &appId)
             Q_EMIT dataChanged(modelIndex, modelIndex, roles);
         }
     });
+    connect(app, &Application::countChanged, this, [this, app] {
+        int i = rowForApplication(app);
+
+        if (i >= 0) {
+            updateRoleCache(i);
+            QModelIndex modelIndex = index(i);
+            QVector<int> roles;
+            roles.append(ApplicationManager::HasCountRole);
+            roles.append(ApplicationManager::CountRole);
+            Q_EMIT dataChanged(modelIndex, modelIndex, roles);
+        }
+    });
+    connect(app, &Application::progressChanged, this, [this, app] {
+        int i = rowForApplication(app);
+
+        if (i >= 0) {
+            updateRoleCache(i);
+            QModelIndex modelIndex = index(i);
+            QVector<int> roles;
+            roles.append(ApplicationManager::HasProgressRole);
+            roles.append(ApplicationManager::ProgressRole);
+            Q_EMIT dataChanged(modelIndex, modelIndex, roles);
+        }
+    });
     connect(app, &Application::launched, this, [this, app] {
         Q_EMIT applicationLaunched(app);
     });
     connect(app, &Application::pinnedChanged, this, [this, app] {
         // Currently pinned launchers
-        QStringList pinnedLaunchers =
-            m_settings->value(QStringLiteral("pinnedLaunchers")).toStringList();
+        QStringList pinnedLaunchers = m_pinnedLaunchers;
         bool changed = false;
 
         // Add or remove from the pinned launchers
@@ -213,18 +241,26 @@ Application *ApplicationManager::newApplication(const QString &appId)
         } else {
             changed = pinnedLaunchers.removeOne(app->appId());
         }
-        if (changed) {
-            int i = m_apps.indexOf(app);
-
-            if (i >= 0) {
-                QModelIndex modelIndex = index(i);
-                QVector<int> roles;
-                roles.append(ApplicationManager::PinnedRole);
-                roles.append(ApplicationManager::PinnedIndexRole);
-                Q_EMIT dataChanged(modelIndex, modelIndex, roles);
-            }
+        // Pinned index is refreshed for all rows when the setting changes
+        int i = rowForApplication(app);
+        bool roleChanged = false;
+        if (i >= 0 && m_roleCache.at(i).at(roleSlot(PinnedRole)).toBool() != app->isPinned()) {
+            m_roleCache[i][roleSlot(PinnedRole)] = app->isPinned();
+            roleChanged = true;
+        }
 
+        // Refresh the cache before views are told, they read it back
+        if (changed) {
             m_settings->setValue(QStringLiteral("pinnedLaunchers"), pinnedLaunchers);
+            updatePinnedIndexes(pinnedLaunchers);
+        }
+
+        // Also announced when the setting was changed outside the shell
+        if (roleChanged) {
+            QModelIndex modelIndex = index(i);
+            QVector<int> roles;
+            roles.append(ApplicationManager::PinnedRole);
+            Q_EMIT dataChanged(modelIndex, modelIndex, roles);
         }
     });
 
@@ -245,90 +281,6 @@ void ApplicationManager::quit(const QString &appId)
         app->quit();
 }
 
-void ApplicationManager::refresh(ApplicationManager *manager)
-{
-    // Identifier of apps that are not in the menu, thus need to be
-    // deleted later
-    QStringList toRemove;
-    for (Application *app : qAsConst(manager->m_apps))
-        toRemove.append(app->appId());
-
-    // Avoid adding duplicate entries
-    QStringList addedEntries;
-
-    XdgMenu xdgMenu;
-    //xdgMenu.setLogDir("/tmp/");
-    xdgMenu.setEnvironments(QStringList() << QStringLiteral("Liri")
-                                          << QStringLiteral("X-Liri"));
-
-    const QString menuFileName = XdgMenu::getMenuFileName();
-
-    qCDebug(APPLICATION_MANAGER) << "Menu file name:" << menuFileName;
-    if (!xdgMenu.read(menuFileName)) {
-        qCWarning(APPLICATION_MANAGER, "Failed to read menu \"%s\": %s",
-                  qPrintable(menuFileName),
-                  qPrintable(xdgMenu.errorString()));
-        return;
-    }
-
-    QDomElement xml = xdgMenu.xml().documentElement();
-
-    DomElementIterator it(xml, QString());
-    while (it.hasNext()) {
-        QDomElement xml = it.next();
-
-        if (xml.tagName() == QStringLiteral("Menu")) {
-            QString categoryName = xml.attribute(QStringLiteral("name"));
-
-            DomElementIterator it(xml, QString());
-            while (it.hasNext()) {
-                QDomElement xml = it.next();
-
-                if (xml.tagName() == QStringLiteral("AppLink")) {
-                    QString desktopFileName = xml.attribute(QStringLiteral("desktopFile"));
-                    QString appId = QFileInfo(desktopFileName).completeBaseName();
-
-                    // App is still in the menu, which means it should not be deleted
-                    toRemove.removeOne(appId);
-
-                    // Ignore desktop files that do not exists
-                    desktopFileName =
-                            QStandardPaths::locate(QStandardPaths::ApplicationsLocation,
-                                                   appId + QStringLiteral(".desktop"));
-                    if (!QFileInfo::exists(desktopFileName))
-                        continue;
-
-                    // Keep track of added entries to avoid duplicates
-                    if (addedEntries.contains(appId))
-                        continue;
-                    addedEntries.append(appId);
-
-                    // Add only valid apps
-                    XdgDesktopFile desktopFile;
-                    if (!desktopFile.load(desktopFileName))
-                        continue;
-                    if (!desktopFile.isValid())
-                        continue;
-
-                    // Add this if we don't have it
-                    if (!manager->findApplication(appId))
-                        QMetaObject::invokeMethod(manager, "addApp", Q_ARG(QString, appId), Q_ARG(QString, categoryName));
-                }
-            }
-        }
-    }
-
-    // Delete apps that are no longer in the menu
-    for (const QString &appId: qAsConst(toRemove)) {
-        Application *app = manager->findApplication(appId);
-        if (app)
-            QMetaObject::invokeMethod(manager, "removeApp", Q_ARG(QObject*, qobject_cast<QObject*>(app)));
-    }
-
-    // Signal the model was refreshed
-    QMetaObject::invokeMethod(manager, "refreshed");
-}
-
 void ApplicationManager::registerShellSurface(QObject *shellSurface)
 {
     QWaylandSurface *surface = shellSurface->property("surface").value<QWaylandSurface *>();
@@ -346,6 +298,8 @@ void ApplicationManager::registerShellSurface(QObject *shellSurface)
     app->m_pids.insert(surface->client()->processId());
     app->addClient(surface->client());
 
+    LaunchStatistics::instance()->surfaceRegistered(appId, surface);
+
     if (!app->desktopFile()->noDisplay())
         UsageTracker::instance()->applicationLaunched(appId);
 
@@ -384,12 +338,11 @@ void ApplicationManager::focusShellSurface(QObject *shellSurface)
 
     Application *app = findApplication(appId);
     if (app) {
+        // Only the previously active application needs to be deactivated
+        if (m_activeApp && m_activeApp != app)
+            m_activeApp->setActive(false);
         app->setActive(true);
-
-        for (Application *app : qAsConst(m_apps)) {
-            if (app->appId() != appId)
-                app->setActive(false);
-        }
+        m_activeApp = app;
 
         if (!app->desktopFile()->noDisplay())
             UsageTracker::instance()->applicationFocused(appId);
@@ -418,21 +371,27 @@ QString ApplicationManager::getIconName(const QString &appId)
 
 int ApplicationManager::indexFromAppId(const QString &appId) const
 {
-    for (int i = 0; i < m_apps.size(); i++) {
-        if (m_apps.at(i)->appId() == appId)
-            return i;
+    return m_appIdToRow.value(appId, -1);
+}
+
+void ApplicationManager::addApp(const MenuCacheApplication &entry)
+{
+    // Applications with windows might have been added already
+    if (findApplication(entry.appId)) {
+        updateApp(entry);
+        return;
     }
 
-    return -1;
+    Application *app = new Application(entry.appId, QStringList() << entry.category, this);
+    app->setCachedEntry(entry.name, entry.genericName, entry.comment, entry.iconName);
+    insertApp(app);
 }
 
-void ApplicationManager::addApp(const QString &appId, const QString &categoryName)
+void ApplicationManager::insertApp(Application *app)
 {
     beginInsertRows(QModelIndex(), m_apps.count(), m_apps.count());
 
-    Application *app = newApplication(appId);
-    if (!app->hasCategory(categoryName))
-        app->m_categories.append(categoryName);
+    setupApplication(app);
 
     Q_EMIT applicationAdded(app);
 
@@ -443,27 +402,152 @@ void ApplicationManager::addApp(const QString &appId, const QString &categoryNam
             Q_EMIT applicationUnpinned(app);
     });
 
-    QStringList pinnedLaunchers = m_settings->value(QStringLiteral("pinnedLaunchers")).toStringList();
-    if (pinnedLaunchers.contains(appId))
+    if (m_pinnedLaunchers.contains(app->appId()))
         app->setPinned(true);
 
     endInsertRows();
 }
 
+void ApplicationManager::updateApp(const MenuCacheApplication &entry)
+{
+    Application *app = findApplication(entry.appId);
+    if (!app) {
+        addApp(entry);
+        return;
+    }
+
+    // Refresh the entry and move it to its new category
+    app->setCachedEntry(entry.name, entry.genericName, entry.comment, entry.iconName);
+    if (app->m_desktopFile)
+        QMetaObject::invokeMethod(app->m_desktopFile, "load");
+    app->m_categories = QStringList() << entry.category;
+
+    int row = rowForApplication(app);
+    updateRoleCache(row);
+    QModelIndex modelIndex = index(row);
+    Q_EMIT dataChanged(modelIndex, modelIndex);
+}
+
 void ApplicationManager::removeApp(QObject *object)
 {
     Application *app = qobject_cast<Application *>(object);
     if (!app)
         return;
 
-    int index = m_apps.indexOf(app);
+    int index = rowForApplication(app);
     if (index < 0)
         return;
 
+    if (m_activeApp == app)
+        m_activeApp = nullptr;
+
     beginRemoveRows(QModelIndex(), index, index);
     m_apps.removeAt(index);
+    m_roleCache.removeAt(index);
+    m_appIdToRow.remove(app->appId());
+    m_appToRow.remove(app);
+    reindexApps(index);
     endRemoveRows();
 
     Q_EMIT applicationRemoved(app);
     app->deleteLater();
 }
+
+int ApplicationManager::rowForApplication(Application *app) const
+{
+    return m_appToRow.value(app, -1);
+}
+
+void ApplicationManager::reindexApps(int from)
+{
+    // Rows after a removed application have shifted up by one
+    for (int i = from; i < m_apps.size(); i++) {
+        Application *app = m_apps.at(i);
+        m_appIdToRow.insert(app->appId(), i);
+        m_appToRow.insert(app, i);
+    }
+}
+
+int ApplicationManager::roleSlot(int role)
+{
+    // Slot 0 holds the decoration, the display role is an alias
+    // for the name and every custom role follows
+    switch (role) {
+    case Qt::DecorationRole:
+        return 0;
+    case Qt::DisplayRole:
+        return NameRole - AppIdRole + 1;
+    default:
+        break;
+    }
+
+    if (role < AppIdRole || role > UsageRankRole)
+        return -1;
+    return role - AppIdRole + 1;
+}
+
+void ApplicationManager::updateRoleCache(int row)
+{
+    Application *app = m_apps.at(row);
+
+    QVector<QVariant> &values = m_roleCache[row];
+    values.resize(UsageRankRole - AppIdRole + 2);
+
+    values[roleSlot(Qt::DecorationRole)] = IconCache::instance()->iconUrl(app->iconName());
+    values[roleSlot(AppIdRole)] = app->appId();
+    values[roleSlot(ApplicationRole)] = qVariantFromValue(app);
+    values[roleSlot(NameRole)] = app->name();
+    values[roleSlot(GenericNameRole)] = app->genericName();
+    values[roleSlot(CommentRole)] = app->comment();
+    values[roleSlot(IconNameRole)] = app->iconName();
+    values[roleSlot(CategoriesRole)] = app->categories();
+    values[roleSlot(FilterInfoRole)] = QString(app->name() + QLatin1Char(' ') +
+                                               app->genericName() + QLatin1Char(' ') +
+                                               app->comment());
+    values[roleSlot(PinnedRole)] = app->isPinned();
+    values[roleSlot(PinnedIndexRole)] = m_pinnedLaunchers.indexOf(app->appId());
+    values[roleSlot(RunningRole)] = app->isRunning();
+    values[roleSlot(StartingRole)] = app->isStarting();
+    values[roleSlot(ActiveRole)] = app->isActive();
+    values[roleSlot(HasWindowsRole)] = false;
+    values[roleSlot(HasCountRole)] = app->count() > 0;
+    values[roleSlot(CountRole)] = app->count();
+    values[roleSlot(HasProgressRole)] = app->progress() >= 0;
+    values[roleSlot(ProgressRole)] = app->progress();
+    values[roleSlot(UsageRankRole)] = UsageTracker::instance()->rankForAppId(app->appId());
+}
+
+void ApplicationManager::handleSettingChanged(const QString &key)
+{
+    if (key != QLatin1String("pinnedLaunchers"))
+        return;
+
+    const QStringList pinnedLaunchers = m_settings->value(QStringLiteral("pinnedLaunchers")).toStringList();
+    updatePinnedIndexes(pinnedLaunchers);
+
+    // Launchers might have been pinned or unpinned outside the shell,
+    // the pinnedChanged() handler refreshes and announces the role
+    const auto apps = m_apps;
+    for (Application *app : apps)
+        app->setPinned(pinnedLaunchers.contains(app->appId()));
+}
+
+void ApplicationManager::updatePinnedIndexes(const QStringList &pinnedLaunchers)
+{
+    m_pinnedLaunchers = pinnedLaunchers;
+
+    // Pinned indexes may have shifted for any application
+    const int slot = roleSlot(PinnedIndexRole);
+    for (int i = 0; i < m_apps.size(); i++) {
+        int pinnedIndex = m_pinnedLaunchers.indexOf(m_apps.at(i)->appId());
+        if (m_roleCache.at(i).at(slot).toInt() == pinnedIndex)
+            continue;
+
+        m_roleCache[i][slot] = pinnedIndex;
+
+        QModelIndex modelIndex = index(i);
+        QVector<int> roles;
+        roles.append(ApplicationManager::PinnedIndexRole);
+        Q_EMIT dataChanged(modelIndex, modelIndex, roles);
+    }
+}
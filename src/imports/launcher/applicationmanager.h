@@ -26,11 +26,13 @@
 
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
 
 #include <Qt5GSettings/QGSettings>
 
-class QDomElement;
 class Application;
+struct MenuCacheApplication;
 
 using namespace QtGSettings;
 
@@ -61,7 +63,8 @@ public:
         CountRole,
         HasProgressRole,
         ProgressRole,
-        ActionsRole
+        ActionsRole,
+        UsageRankRole
     };
     Q_ENUM(Roles)
 
@@ -87,8 +90,6 @@ public:
     Q_INVOKABLE QString getIconName(const QString &appId);
     Q_INVOKABLE int indexFromAppId(const QString &appId) const;
 
-    static void refresh(ApplicationManager *manager);
-
 public Q_SLOTS:
     void launch(const QString &appId);
     void quit(const QString &appId);
@@ -104,9 +105,26 @@ Q_SIGNALS:
 private:
     QGSettings *m_settings = nullptr;
     QList<Application *> m_apps;
+    QHash<QString, int> m_appIdToRow;
+    QHash<Application *, int> m_appToRow;
+    Application *m_activeApp = nullptr;
     QMap<QObject *, QString> m_shellSurfaces;
+    QStringList m_pinnedLaunchers;
+    QVector<QVector<QVariant>> m_roleCache;
+
+    Application *setupApplication(Application *app);
+    void addApp(const MenuCacheApplication &entry);
+    void updateApp(const MenuCacheApplication &entry);
+    void insertApp(Application *app);
+
+    int rowForApplication(Application *app) const;
+    void reindexApps(int from);
+
+    static int roleSlot(int role);
+    void updateRoleCache(int row);
+    void updatePinnedIndexes(const QStringList &pinnedLaunchers);
 
 private Q_SLOTS:
-    void addApp(const QString &appId, const QString &categoryName);
     void removeApp(QObject *object);
+    void handleSettingChanged(const QString &key);
 };
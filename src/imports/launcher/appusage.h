@@ -29,7 +29,6 @@
 #include <QtCore/QObject>
 
 #include <QtCore/QDateTime>
-#include <QtSql/QSqlDatabase>
 
 class AppUsage : QObject
 {
@@ -42,9 +41,6 @@ public:
     QDateTime lastSeen;
     int score = 0;
 
-    void save() const;
-    void destroy() const;
-
-private:
-    QSqlDatabase m_db;
+    // Position in the usage ranking, -1 when never used
+    int rank = -1;
 };
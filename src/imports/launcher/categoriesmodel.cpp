@@ -24,17 +24,9 @@
  * $END_LICENSE$
  ***************************************************************************/
 
-#include <QtCore/QFileSystemWatcher>
-#include <QtCore/QFuture>
-#include <QtCore/QThread>
-#include <QtConcurrent/QtConcurrentRun>
-#include <QtGui/QIcon>
-
-#include <qt5xdg/xdgmenu.h>
-#include <qt5xdg/xmlhelper.h>
-
 #include "categoriesmodel.h"
-#include "utils.h"
+#include "iconcache.h"
+#include "menuindex.h"
 
 class CategoryEntry
 {
@@ -53,17 +45,23 @@ public:
 
 CategoriesModel::CategoriesModel(QObject *parent)
     : QAbstractListModel(parent)
-    , m_initialized(false)
     , m_allCategory(true)
 {
-    qRegisterMetaType<CategoryEntry *>("CategoryEntry*");
+    createAllCategory();
 
-    QtConcurrent::run(CategoriesModel::refresh, this);
+    // Start from the current menu and follow its changes
+    MenuIndex *menuIndex = MenuIndex::instance();
+    populate();
+    connect(menuIndex, &MenuIndex::categoriesChanged, this, &CategoriesModel::populate);
+    connect(menuIndex, &MenuIndex::refreshing, this, &CategoriesModel::refreshing);
 
-    QFileSystemWatcher *watcher = new QFileSystemWatcher(this);
-    watcher->addPaths(xdgApplicationsPaths());
-    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &) {
-        QtConcurrent::run(CategoriesModel::refresh, this);
+    connect(IconCache::instance(), &IconCache::themeChanged, this, [this] {
+        if (m_list.isEmpty())
+            return;
+
+        QVector<int> roles;
+        roles.append(Qt::DecorationRole);
+        Q_EMIT dataChanged(index(0), index(m_list.size() - 1), roles);
     });
 }
 
@@ -125,7 +123,7 @@ QVariant CategoriesModel::data(const QModelIndex &index, int role) const
 
     switch (role) {
     case Qt::DecorationRole:
-        return QIcon::fromTheme(item->iconName);
+        return IconCache::instance()->iconUrl(item->iconName);
     case Qt::DisplayRole:
     case NameRole:
         return item->name;
@@ -142,82 +140,6 @@ QVariant CategoriesModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-void CategoriesModel::refresh(CategoriesModel *model)
-{
-    // Create the 'All' category for the first time, if needed
-    if (!model->m_initialized) {
-        model->m_initialized = true;
-        if (model->m_allCategory)
-            QMetaObject::invokeMethod(model, "createAllCategory");
-    }
-
-    // List of categories that are no longer in the menu, at first
-    // we assume that all of theme will have to be removed
-    QStringList toRemove;
-    for (CategoryEntry *category : qAsConst(model->m_list)) {
-        if (category->name != tr("All"))
-            toRemove.append(category->name);
-    }
-
-    QMetaObject::invokeMethod(model, "refreshing");
-
-    XdgMenu xdgMenu;
-    //xdgMenu.setLogDir(QStringLiteral("/tmp/"));
-    xdgMenu.setEnvironments(QStringList() << QStringLiteral("Liri") << QStringLiteral("X-Liri"));
-    const QString menuFileName = XdgMenu::getMenuFileName();
-    if (!xdgMenu.read(menuFileName)) {
-        qWarning("Failed to read menu \"%s\": %s", qPrintable(menuFileName),
-                 qPrintable(xdgMenu.errorString()));
-        return;
-    }
-
-    QDomElement xml = xdgMenu.xml().documentElement();
-
-    DomElementIterator it(xml, QString());
-    while (it.hasNext()) {
-        QDomElement xml = it.next();
-
-        if (xml.tagName() == QStringLiteral("Menu")) {
-            QString name = xml.attribute(QStringLiteral("name"));
-            if (!xml.attribute(QStringLiteral("title")).isEmpty())
-                name = xml.attribute(QStringLiteral("title"));
-
-            // This entry is still in the menu, we don't have to remove it
-            toRemove.removeOne(name);
-
-            // Do not add duplicate entries
-            bool found = false;
-            for (CategoryEntry *entry : qAsConst(model->m_list)) {
-                if (entry->name == name) {
-                    found = true;
-                    break;
-                }
-            }
-            if (found)
-                break;
-
-            // Create entry
-            CategoryEntry *entry = new CategoryEntry();
-            if (!xml.attribute(QStringLiteral("title")).isEmpty())
-                entry->name = xml.attribute(QStringLiteral("title"));
-            else
-                entry->name = xml.attribute(QStringLiteral("name"));
-            entry->comment = xml.attribute(QStringLiteral("comment"));
-            entry->iconName = xml.attribute(QStringLiteral("icon"));
-            entry->category = xml.attribute(QStringLiteral("name"));
-
-            // Add entry
-            QMetaObject::invokeMethod(model, "addEntry", Q_ARG(CategoryEntry*, entry));
-        }
-    }
-
-    // Remove categories that are no longer in the menu
-    //QMetaObject::invokeMethod(model, "cleanModel", Q_ARG(QStringList, toRemove));
-
-    // Sort
-    QMetaObject::invokeMethod(model, "sortModel");
-}
-
 void CategoriesModel::createAllCategory()
 {
     beginInsertRows(QModelIndex(), 0, 0);
@@ -226,43 +148,33 @@ void CategoriesModel::createAllCategory()
     allCategory->comment = tr("All categories");
     allCategory->iconName = QStringLiteral("applications-other");
     allCategory->category = QString();
-    m_list.append(allCategory);
+    m_list.prepend(allCategory);
     endInsertRows();
 }
 
-void CategoriesModel::addEntry(CategoryEntry *entry)
+void CategoriesModel::populate()
 {
-    beginInsertRows(QModelIndex(), m_list.count(), m_list.count());
-    m_list.append(entry);
-    endInsertRows();
-}
+    beginResetModel();
 
-void CategoriesModel::cleanModel(const QStringList &list)
-{
-    for (const QString &name : qAsConst(list)) {
-        auto it = m_list.begin();
-        while (it != m_list.end()) {
-            CategoryEntry *entry = (*it);
-            if (entry->name == name) {
-                int index = m_list.indexOf(entry);
-                beginRemoveRows(QModelIndex(), index, index);
-                it = m_list.erase(it);
-                endRemoveRows();
-                delete entry;
-            } else {
-                it++;
-            }
-        }
+    // Categories are few, just start over
+    while (m_list.size() > (m_allCategory ? 1 : 0))
+        delete m_list.takeLast();
+
+    const MenuSnapshot snapshot = MenuIndex::instance()->snapshot();
+    for (const MenuCacheCategory &category : snapshot->categories) {
+        CategoryEntry *entry = new CategoryEntry();
+        entry->name = category.title.isEmpty() ? category.name : category.title;
+        entry->comment = category.comment;
+        entry->iconName = category.iconName;
+        entry->category = category.name;
+        m_list.append(entry);
     }
-}
 
-void CategoriesModel::sortModel()
-{
-    beginResetModel();
     if (m_allCategory)
         qSort(m_list.begin() + 1, m_list.end(), CategoryEntry::lessThan);
     else
         qSort(m_list.begin(), m_list.end(), CategoryEntry::lessThan);
+
     endResetModel();
 }
 
@@ -62,17 +62,13 @@ Q_SIGNALS:
     void refreshing();
 
 private:
-    bool m_initialized;
     QList<CategoryEntry *> m_list;
     bool m_allCategory;
 
-    static void refresh(CategoriesModel *model);
+    void createAllCategory();
 
 private Q_SLOTS:
-    void createAllCategory();
-    void addEntry(CategoryEntry *entry);
-    void cleanModel(const QStringList &list);
-    void sortModel();
+    void populate();
 };
 
 QML_DECLARE_TYPE(CategoriesModel)
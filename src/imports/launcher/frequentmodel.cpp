@@ -3,8 +3,9 @@
 #include <QtCore/QDebug>
 #include <QtCore/QFileInfo>
 
+#include <algorithm>
+
 #include "applicationmanager.h"
-#include "usagetracker.h"
 
 QString appIdFromDesktopFile(const QString &desktopFile)
 {
@@ -12,37 +13,354 @@ QString appIdFromDesktopFile(const QString &desktopFile)
 }
 
 FrequentAppsModel::FrequentAppsModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractProxyModel(parent)
+{
+}
+
+int FrequentAppsModel::limitCount() const
+{
+    return m_limitCount;
+}
+
+void FrequentAppsModel::setLimitCount(int limitCount)
 {
-    sort(0, Qt::DescendingOrder);
+    if (m_limitCount == limitCount)
+        return;
 
-    connect(UsageTracker::instance(), &UsageTracker::updated, this, &FrequentAppsModel::invalidate);
+    beginResetModel();
+    m_limitCount = limitCount;
+    m_rowCount = visibleCount();
+    endResetModel();
+
+    Q_EMIT limitCountChanged();
 }
 
-bool FrequentAppsModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+void FrequentAppsModel::setSourceModel(QAbstractItemModel *newSourceModel)
 {
-    QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
-    QString appId = sourceModel()->data(sourceIndex, ApplicationManager::AppIdRole).toString();
+    beginResetModel();
+
+    if (sourceModel())
+        disconnect(sourceModel(), nullptr, this, nullptr);
 
-    AppUsage *app = UsageTracker::instance()->usageForAppId(appId);
+    QAbstractProxyModel::setSourceModel(newSourceModel);
 
-    return app != nullptr && app->score > 0;
+    if (newSourceModel) {
+        connect(newSourceModel, &QAbstractItemModel::rowsInserted,
+                this, &FrequentAppsModel::handleRowsInserted);
+        connect(newSourceModel, &QAbstractItemModel::rowsAboutToBeRemoved,
+                this, &FrequentAppsModel::handleRowsAboutToBeRemoved);
+        connect(newSourceModel, &QAbstractItemModel::rowsRemoved,
+                this, &FrequentAppsModel::handleRowsRemoved);
+        connect(newSourceModel, &QAbstractItemModel::dataChanged,
+                this, &FrequentAppsModel::handleDataChanged);
+
+        // Rare enough to start over
+        connect(newSourceModel, &QAbstractItemModel::modelAboutToBeReset,
+                this, &FrequentAppsModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::modelReset, this, [this] {
+            rebuild();
+            endResetModel();
+        });
+        connect(newSourceModel, &QAbstractItemModel::layoutAboutToBeChanged,
+                this, &FrequentAppsModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::layoutChanged, this, [this] {
+            rebuild();
+            endResetModel();
+        });
+        connect(newSourceModel, &QAbstractItemModel::rowsAboutToBeMoved,
+                this, &FrequentAppsModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::rowsMoved, this, [this] {
+            rebuild();
+            endResetModel();
+        });
+    }
+
+    rebuild();
+    endResetModel();
 }
 
-bool FrequentAppsModel::lessThan(const QModelIndex &source_left,
-                                 const QModelIndex &source_right) const
+QModelIndex FrequentAppsModel::mapToSource(const QModelIndex &proxyIndex) const
 {
-    QString leftAppId = sourceModel()->data(source_left, ApplicationManager::AppIdRole).toString();
-    QString rightAppId = sourceModel()->data(source_right, ApplicationManager::AppIdRole).toString();
+    if (!sourceModel() || !proxyIndex.isValid() || proxyIndex.row() >= m_rowCount)
+        return QModelIndex();
+    return sourceModel()->index(m_sourceRows.at(proxyIndex.row()), proxyIndex.column());
+}
 
-    AppUsage *leftApp = UsageTracker::instance()->usageForAppId(leftAppId);
-    AppUsage *rightApp = UsageTracker::instance()->usageForAppId(rightAppId);
+QModelIndex FrequentAppsModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+
+    int row = positionOf(sourceIndex.row());
+    if (row < 0 || row >= m_rowCount)
+        return QModelIndex();
+    return index(row, sourceIndex.column());
+}
+
+QModelIndex FrequentAppsModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= m_rowCount || column != 0)
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex FrequentAppsModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int FrequentAppsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int FrequentAppsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+int FrequentAppsModel::rankAt(int sourceRow) const
+{
+    return sourceModel()->index(sourceRow, 0).data(ApplicationManager::UsageRankRole).toInt();
+}
+
+int FrequentAppsModel::positionOf(int sourceRow) const
+{
+    if (sourceRow < 0 || sourceRow >= m_positions.size())
+        return -1;
+    return m_positions.at(sourceRow);
+}
+
+/*
+ * Refresh the position of every entry between first and last.
+ * This is linear in the distance an entry moved, or in the number of
+ * entries after the insertion or removal point: lookups are constant
+ * time but updates are not logarithmic.
+ */
+void FrequentAppsModel::updatePositions(int first, int last)
+{
+    for (int pos = first; pos <= last; pos++)
+        m_positions[m_sourceRows.at(pos)] = pos;
+}
+
+int FrequentAppsModel::visibleCount() const
+{
+    if (m_limitCount > 0)
+        return qMin(m_sourceRows.size(), m_limitCount);
+    return m_sourceRows.size();
+}
+
+/*
+ * Binary search for the position of rank, ignoring the entry at skip.
+ * Ranks of other applications might not be updated yet, ties are
+ * broken in the direction the application is moving.
+ */
+int FrequentAppsModel::findPosition(int rank, int skip, bool afterTies) const
+{
+    int low = 0;
+    int high = m_sourceRows.size() - (skip >= 0 ? 1 : 0);
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+        int entry = skip >= 0 && middle >= skip ? middle + 1 : middle;
+        int entryRank = rankAt(m_sourceRows.at(entry));
+
+        if (afterTies ? entryRank <= rank : entryRank < rank)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+void FrequentAppsModel::rebuild()
+{
+    m_sourceRows.clear();
+    m_positions.clear();
+
+    if (sourceModel()) {
+        m_positions.fill(-1, sourceModel()->rowCount());
+
+        QVector<QPair<int, int> > ranked;
+        for (int row = 0; row < sourceModel()->rowCount(); row++) {
+            int rank = rankAt(row);
+            if (rank >= 0)
+                ranked.append(qMakePair(rank, row));
+        }
+        std::sort(ranked.begin(), ranked.end());
+
+        for (const auto &pair : qAsConst(ranked))
+            m_sourceRows.append(pair.second);
+        updatePositions(0, m_sourceRows.size() - 1);
+    }
 
-    if (leftApp == nullptr) {
-        return false;
-    } else if (rightApp == nullptr) {
-        return true;
+    m_rowCount = visibleCount();
+}
+
+void FrequentAppsModel::updateRow(int sourceRow)
+{
+    const int rank = rankAt(sourceRow);
+    const int pos = positionOf(sourceRow);
+
+    if (pos < 0) {
+        if (rank >= 0)
+            insertEntry(findPosition(rank, -1, false), sourceRow);
+        return;
+    }
+
+    if (rank < 0) {
+        removeEntry(pos);
+        return;
+    }
+
+    // Applications that were just pushed by another one are still in order
+    const bool afterPrevious = pos == 0 || rankAt(m_sourceRows.at(pos - 1)) <= rank;
+    const bool beforeNext = pos == m_sourceRows.size() - 1 || rankAt(m_sourceRows.at(pos + 1)) >= rank;
+    if (afterPrevious && beforeNext)
+        return;
+
+    moveEntry(pos, findPosition(rank, pos, !beforeNext));
+}
+
+void FrequentAppsModel::insertEntry(int pos, int sourceRow)
+{
+    if (m_limitCount > 0 && pos >= m_limitCount) {
+        m_sourceRows.insert(pos, sourceRow);
+        updatePositions(pos, m_sourceRows.size() - 1);
+        return;
+    }
+
+    // Make room by pushing the last visible entry out
+    if (m_limitCount > 0 && m_rowCount == m_limitCount) {
+        beginRemoveRows(QModelIndex(), m_rowCount - 1, m_rowCount - 1);
+        m_rowCount--;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), pos, pos);
+    m_sourceRows.insert(pos, sourceRow);
+    updatePositions(pos, m_sourceRows.size() - 1);
+    m_rowCount++;
+    endInsertRows();
+}
+
+void FrequentAppsModel::removeEntry(int pos)
+{
+    m_positions[m_sourceRows.at(pos)] = -1;
+
+    if (pos >= m_rowCount) {
+        m_sourceRows.removeAt(pos);
+        updatePositions(pos, m_sourceRows.size() - 1);
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), pos, pos);
+    m_sourceRows.removeAt(pos);
+    updatePositions(pos, m_sourceRows.size() - 1);
+    m_rowCount--;
+    endRemoveRows();
+
+    // The first hidden entry becomes visible
+    if (visibleCount() > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, m_rowCount);
+        m_rowCount++;
+        endInsertRows();
+    }
+}
+
+void FrequentAppsModel::moveEntry(int from, int to)
+{
+    if (from == to)
+        return;
+
+    if (from < m_rowCount && to < m_rowCount) {
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        m_sourceRows.move(from, to);
+        updatePositions(qMin(from, to), qMax(from, to));
+        endMoveRows();
+    } else if (from < m_rowCount) {
+        // Leaving the visible entries, the first hidden one takes its place
+        beginRemoveRows(QModelIndex(), from, from);
+        m_sourceRows.move(from, to);
+        updatePositions(qMin(from, to), qMax(from, to));
+        m_rowCount--;
+        endRemoveRows();
+
+        beginInsertRows(QModelIndex(), m_rowCount, m_rowCount);
+        m_rowCount++;
+        endInsertRows();
+    } else if (to < m_rowCount) {
+        // Entering the visible entries, the last visible one gets hidden
+        beginRemoveRows(QModelIndex(), m_rowCount - 1, m_rowCount - 1);
+        m_rowCount--;
+        endRemoveRows();
+
+        beginInsertRows(QModelIndex(), to, to);
+        m_sourceRows.move(from, to);
+        updatePositions(qMin(from, to), qMax(from, to));
+        m_rowCount++;
+        endInsertRows();
     } else {
-        return leftApp->score < rightApp->score;
+        m_sourceRows.move(from, to);
+        updatePositions(qMin(from, to), qMax(from, to));
+    }
+}
+
+void FrequentAppsModel::handleRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int count = last - first + 1;
+    m_positions.insert(first, count, -1);
+    for (int &sourceRow : m_sourceRows) {
+        if (sourceRow >= first)
+            sourceRow += count;
+    }
+
+    for (int row = first; row <= last; row++)
+        updateRow(row);
+}
+
+void FrequentAppsModel::handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    for (int row = first; row <= last; row++) {
+        int pos = positionOf(row);
+        if (pos >= 0)
+            removeEntry(pos);
+    }
+}
+
+void FrequentAppsModel::handleRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int count = last - first + 1;
+    m_positions.remove(first, count);
+    for (int &sourceRow : m_sourceRows) {
+        if (sourceRow > last)
+            sourceRow -= count;
+    }
+}
+
+void FrequentAppsModel::handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                          const QVector<int> &roles)
+{
+    if (topLeft.parent().isValid())
+        return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        if (roles.isEmpty() || roles.contains(ApplicationManager::UsageRankRole))
+            updateRow(row);
+
+        const QModelIndex proxyIndex = mapFromSource(sourceModel()->index(row, 0));
+        if (proxyIndex.isValid())
+            Q_EMIT dataChanged(proxyIndex, proxyIndex, roles);
     }
 }
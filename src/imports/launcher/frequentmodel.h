@@ -23,22 +23,65 @@
 
 #pragma once
 
-#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QAbstractProxyModel>
+#include <QtCore/QVector>
 #include <QtQml/QQmlComponent>
 
-class FrequentAppsModel : public QSortFilterProxyModel
+/**
+ * Lists used applications from the most to the least used one, up to limitCount.
+ * Rank changes are applied by moving the affected rows rather than sorting again,
+ * so views keep their delegates.
+ */
+class FrequentAppsModel : public QAbstractProxyModel
 {
     Q_OBJECT
+    Q_PROPERTY(int limitCount READ limitCount WRITE setLimitCount NOTIFY limitCountChanged)
 
 public:
     FrequentAppsModel(QObject *parent = nullptr);
 
-    int startIndex() const;
     int limitCount() const;
+    void setLimitCount(int limitCount);
 
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
-    bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+Q_SIGNALS:
+    void limitCountChanged();
+
+private:
+    // Source rows of ranked applications, the first m_rowCount are exposed
+    QVector<int> m_sourceRows;
+    // Position in m_sourceRows of every source row, -1 when not ranked
+    QVector<int> m_positions;
+    int m_rowCount = 0;
+    int m_limitCount = 0;
+
+    int rankAt(int sourceRow) const;
+    int positionOf(int sourceRow) const;
+    void updatePositions(int first, int last);
+    int visibleCount() const;
+    int findPosition(int rank, int skip, bool afterTies) const;
+
+    void rebuild();
+    void updateRow(int sourceRow);
+    void insertEntry(int pos, int sourceRow);
+    void removeEntry(int pos);
+    void moveEntry(int from, int to);
+
+    void handleRowsInserted(const QModelIndex &parent, int first, int last);
+    void handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void handleRowsRemoved(const QModelIndex &parent, int first, int last);
+    void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                           const QVector<int> &roles);
 };
 
 QML_DECLARE_TYPE(FrequentAppsModel)
@@ -0,0 +1,167 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QFileInfo>
+#include <QtGui/QIcon>
+#include <QtGui/QImageReader>
+
+#include "iconcache.h"
+
+Q_LOGGING_CATEGORY(ICON_CACHE, "liri.launcher.iconcache")
+
+/*
+ * How many bytes of rasterized icons we keep around, enough for
+ * a few hundred icons at the sizes used by launcher and dock
+ */
+#define ICON_CACHE_SIZE (16 * 1024 * 1024)
+
+Q_GLOBAL_STATIC(IconCache, s_iconCache)
+
+static QImage readIcon(const QString &fileName, const QSize &size)
+{
+    QImageReader reader(fileName);
+
+    // Vector images are rendered right at the requested size
+    if (reader.supportsOption(QImageIOHandler::ScaledSize) && reader.format().startsWith("svg")) {
+        reader.setScaledSize(reader.size().scaled(size, Qt::KeepAspectRatio));
+        return reader.read();
+    }
+
+    QImage image = reader.read();
+    if (!image.isNull() && image.size() != size)
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
+
+IconCache::IconCache(QObject *parent)
+    : QObject(parent)
+    , m_themeName(QIcon::themeName())
+    , m_images(ICON_CACHE_SIZE)
+{
+    m_settings = new QtGSettings::QGSettings(QStringLiteral("io.liri.desktop.interface"),
+                                             QStringLiteral("/io/liri/desktop/interface/"),
+                                             this);
+    connect(m_settings, &QtGSettings::QGSettings::settingChanged,
+            this, &IconCache::handleSettingChanged);
+}
+
+IconCache *IconCache::instance()
+{
+    return s_iconCache;
+}
+
+QString IconCache::providerName()
+{
+    return QStringLiteral("appicons");
+}
+
+int IconCache::generation() const
+{
+    return m_generation.load();
+}
+
+QUrl IconCache::iconUrl(const QString &iconName) const
+{
+    if (iconName.isEmpty())
+        return QUrl();
+
+    // Anything after the question mark only defeats QML caches
+    return QUrl(QStringLiteral("image://%1/%2?%3")
+                .arg(providerName(), iconName)
+                .arg(m_generation.load()));
+}
+
+QImage IconCache::image(const QString &iconName, const QSize &size)
+{
+    QString key;
+    QString themeName;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // Qt scales the source size of image provider requests by the
+        // device pixel ratio of the window, sizes are in device pixels
+        // and each scale factor gets its own images
+        key = QStringLiteral("%1/%2@%3x%4").arg(m_themeName, iconName)
+                .arg(size.width()).arg(size.height());
+        themeName = m_themeName;
+
+        QImage *image = m_images.object(key);
+        if (image)
+            return *image;
+    }
+
+    // QIcon shares its loader with the GUI thread, look files up ourselves
+    QString fileName;
+    if (QFileInfo(iconName).isAbsolute()) {
+        fileName = iconName;
+    } else {
+        // Some desktop entries put the extension in the icon name
+        QString name = iconName;
+        if (name.endsWith(QLatin1String(".png")) || name.endsWith(QLatin1String(".svg")) ||
+                name.endsWith(QLatin1String(".xpm")))
+            name.chop(4);
+
+        const int iconSize = qMax(size.width(), size.height());
+
+        QMutexLocker locker(&m_resolverMutex);
+        fileName = m_resolver.findIcon(themeName, name, iconSize, 1);
+        if (fileName.isEmpty())
+            fileName = m_resolver.findIcon(themeName, QStringLiteral("application-x-executable"), iconSize, 1);
+    }
+
+    // Rasterization happens without holding any lock,
+    // at worst two threads render the same icon once
+    const QImage image = fileName.isEmpty() ? QImage() : readIcon(fileName, size);
+
+    QMutexLocker locker(&m_mutex);
+    m_images.insert(key, new QImage(image), qMax(1, image.byteCount()));
+
+    return image;
+}
+
+void IconCache::handleSettingChanged(const QString &key)
+{
+    if (key != QLatin1String("iconTheme"))
+        return;
+
+    const QString themeName = m_settings->value(QStringLiteral("iconTheme")).toString();
+
+    qCDebug(ICON_CACHE, "Icon theme changed to \"%s\"", qPrintable(themeName));
+
+    // Other icons of the shell follow the setting too, this runs on the GUI thread
+    QIcon::setThemeName(themeName);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_themeName = themeName;
+        m_images.clear();
+    }
+    {
+        // Themes might have been installed or updated too
+        QMutexLocker locker(&m_resolverMutex);
+        m_resolver.clear();
+    }
+
+    m_generation.ref();
+    Q_EMIT themeChanged();
+}
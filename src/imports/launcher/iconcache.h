@@ -0,0 +1,80 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QCache>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtGui/QImage>
+
+#include <Qt5GSettings/QGSettings>
+
+#include "iconthemeresolver.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ICON_CACHE)
+
+/*!
+ * Rasterized icons shared by every view and output.
+ *
+ * Images are looked up and rasterized at most once per icon theme and
+ * size in device pixels, from the image provider thread, and kept in a
+ * bounded LRU. Lookups go through IconThemeResolver rather than QIcon,
+ * whose loader belongs to the GUI thread.
+ * Models hand out the URL returned by iconUrl(), which changes along
+ * with the icon theme so that QML reloads images; QML code builds
+ * them through the IconCache singleton of Liri.Launcher.
+ */
+class IconCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int generation READ generation NOTIFY themeChanged)
+public:
+    explicit IconCache(QObject *parent = nullptr);
+
+    static IconCache *instance();
+    static QString providerName();
+
+    int generation() const;
+
+    Q_INVOKABLE QUrl iconUrl(const QString &iconName) const;
+
+    QImage image(const QString &iconName, const QSize &size);
+
+Q_SIGNALS:
+    void themeChanged();
+
+private:
+    QtGSettings::QGSettings *m_settings = nullptr;
+    QMutex m_mutex;
+    QString m_themeName;
+    QCache<QString, QImage> m_images;
+    QMutex m_resolverMutex;
+    IconThemeResolver m_resolver;
+    QAtomicInt m_generation;
+
+private Q_SLOTS:
+    void handleSettingChanged(const QString &key);
+};
@@ -0,0 +1,50 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "iconcache.h"
+#include "iconimageprovider.h"
+
+// Used when QML doesn't specify a source size
+#define ICON_DEFAULT_SIZE 64
+
+IconImageProvider::IconImageProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image,
+                          QQmlImageProviderBase::ForceAsynchronousImageLoading)
+{
+}
+
+QImage IconImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const QString iconName = id.section(QLatin1Char('?'), 0, 0);
+
+    QSize iconSize = requestedSize;
+    if (iconSize.width() <= 0)
+        iconSize.setWidth(iconSize.height() > 0 ? iconSize.height() : ICON_DEFAULT_SIZE);
+    if (iconSize.height() <= 0)
+        iconSize.setHeight(iconSize.width());
+
+    const QImage image = IconCache::instance()->image(iconName, iconSize);
+    if (size)
+        *size = image.size();
+    return image;
+}
@@ -0,0 +1,218 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <climits>
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
+
+#include "iconthemeresolver.h"
+
+static QStringList iconExtensions()
+{
+    return QStringList() << QStringLiteral("png") << QStringLiteral("svg") << QStringLiteral("xpm");
+}
+
+IconThemeResolver::IconThemeResolver()
+{
+    // Search order mandated by the specification
+    m_baseDirs.append(QDir::home().absoluteFilePath(QStringLiteral(".icons")));
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDir : dataDirs)
+        m_baseDirs.append(QDir(dataDir).absoluteFilePath(QStringLiteral("icons")));
+}
+
+void IconThemeResolver::clear()
+{
+    m_themes.clear();
+}
+
+QString IconThemeResolver::findIcon(const QString &themeName, const QString &iconName, int size, int scale)
+{
+    // Walk the inheritance tree breadth first, hicolor is always last
+    QStringList queue = QStringList() << themeName;
+    QSet<QString> visited;
+    while (!queue.isEmpty()) {
+        const QString name = queue.takeFirst();
+        if (name.isEmpty() || visited.contains(name))
+            continue;
+        visited.insert(name);
+
+        const Theme &current = theme(name);
+        const QString fileName = lookupIcon(current, iconName, size, scale);
+        if (!fileName.isEmpty())
+            return fileName;
+
+        queue.append(current.parents);
+        if (queue.isEmpty() && !visited.contains(QStringLiteral("hicolor")))
+            queue.append(QStringLiteral("hicolor"));
+    }
+
+    return fallbackIcon(iconName);
+}
+
+const IconThemeResolver::Theme &IconThemeResolver::theme(const QString &themeName)
+{
+    auto it = m_themes.constFind(themeName);
+    if (it != m_themes.constEnd())
+        return it.value();
+
+    Theme &theme = m_themes[themeName];
+
+    // The first index file found describes the theme
+    QStringList directoryNames;
+    for (const QString &baseDir : qAsConst(m_baseDirs)) {
+        const QString indexFileName = QDir(baseDir).absoluteFilePath(themeName + QStringLiteral("/index.theme"));
+        if (!QFileInfo::exists(indexFileName))
+            continue;
+
+        QSettings index(indexFileName, QSettings::IniFormat);
+        theme.parents = index.value(QStringLiteral("Icon Theme/Inherits")).toStringList();
+        directoryNames = index.value(QStringLiteral("Icon Theme/Directories")).toStringList();
+        directoryNames += index.value(QStringLiteral("Icon Theme/ScaledDirectories")).toStringList();
+
+        for (const QString &directoryName : qAsConst(directoryNames)) {
+            index.beginGroup(directoryName);
+
+            Directory directory;
+            directory.size = index.value(QStringLiteral("Size")).toInt();
+            directory.scale = index.value(QStringLiteral("Scale"), 1).toInt();
+            directory.minSize = index.value(QStringLiteral("MinSize"), directory.size).toInt();
+            directory.maxSize = index.value(QStringLiteral("MaxSize"), directory.size).toInt();
+            directory.threshold = index.value(QStringLiteral("Threshold"), 2).toInt();
+
+            const QString type = index.value(QStringLiteral("Type")).toString();
+            if (type == QLatin1String("Fixed"))
+                directory.type = Directory::Fixed;
+            else if (type == QLatin1String("Scalable"))
+                directory.type = Directory::Scalable;
+            else
+                directory.type = Directory::Threshold;
+
+            theme.directories.append(directory);
+            index.endGroup();
+        }
+
+        break;
+    }
+
+    // List every directory once, icons are then found without touching the disk
+    const QStringList extensions = iconExtensions();
+    for (int i = 0; i < directoryNames.size(); i++) {
+        for (const QString &baseDir : qAsConst(m_baseDirs)) {
+            QDir dir(QDir(baseDir).absoluteFilePath(themeName + QLatin1Char('/') + directoryNames.at(i)));
+            const QFileInfoList files = dir.entryInfoList(QDir::Files);
+            for (const QFileInfo &fileInfo : files) {
+                if (!extensions.contains(fileInfo.suffix()))
+                    continue;
+                theme.icons[fileInfo.completeBaseName()].append(qMakePair(i, fileInfo.absoluteFilePath()));
+            }
+        }
+    }
+
+    return theme;
+}
+
+QString IconThemeResolver::lookupIcon(const Theme &theme, const QString &iconName, int size, int scale) const
+{
+    auto it = theme.icons.constFind(iconName);
+    if (it == theme.icons.constEnd())
+        return QString();
+
+    QString closestFileName;
+    int minimalDistance = INT_MAX;
+
+    for (const auto &entry : it.value()) {
+        const Directory &directory = theme.directories.at(entry.first);
+        if (directoryMatchesSize(directory, size, scale))
+            return entry.second;
+
+        const int distance = directorySizeDistance(directory, size, scale);
+        if (distance < minimalDistance) {
+            minimalDistance = distance;
+            closestFileName = entry.second;
+        }
+    }
+
+    return closestFileName;
+}
+
+QString IconThemeResolver::fallbackIcon(const QString &iconName) const
+{
+    const QStringList dirs = QStringList(m_baseDirs) << QStringLiteral("/usr/share/pixmaps");
+    const QStringList extensions = iconExtensions();
+    for (const QString &dirName : dirs) {
+        for (const QString &extension : extensions) {
+            const QString fileName = QDir(dirName).absoluteFilePath(iconName + QLatin1Char('.') + extension);
+            if (QFileInfo::exists(fileName))
+                return fileName;
+        }
+    }
+
+    return QString();
+}
+
+bool IconThemeResolver::directoryMatchesSize(const Directory &directory, int size, int scale)
+{
+    if (directory.scale != scale)
+        return false;
+
+    switch (directory.type) {
+    case Directory::Fixed:
+        return directory.size == size;
+    case Directory::Scalable:
+        return directory.minSize <= size && size <= directory.maxSize;
+    case Directory::Threshold:
+        return directory.size - directory.threshold <= size &&
+                size <= directory.size + directory.threshold;
+    }
+
+    return false;
+}
+
+int IconThemeResolver::directorySizeDistance(const Directory &directory, int size, int scale)
+{
+    const int scaledSize = size * scale;
+
+    switch (directory.type) {
+    case Directory::Fixed:
+        return qAbs(directory.size * directory.scale - scaledSize);
+    case Directory::Scalable:
+        if (scaledSize < directory.minSize * directory.scale)
+            return directory.minSize * directory.scale - scaledSize;
+        if (scaledSize > directory.maxSize * directory.scale)
+            return scaledSize - directory.maxSize * directory.scale;
+        return 0;
+    case Directory::Threshold:
+        if (scaledSize < (directory.size - directory.threshold) * directory.scale)
+            return directory.minSize * directory.scale - scaledSize;
+        if (scaledSize > (directory.size + directory.threshold) * directory.scale)
+            return scaledSize - directory.maxSize * directory.scale;
+        return 0;
+    }
+
+    return INT_MAX;
+}
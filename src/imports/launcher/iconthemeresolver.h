@@ -0,0 +1,82 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+/*!
+ * Finds icon files following the freedesktop.org icon theme
+ * specification.
+ *
+ * Unlike QIcon it doesn't share state with the GUI thread, so it can
+ * be used from the image provider thread. Callers serialize access.
+ * Themes are indexed the first time they are needed: every icon
+ * directory is listed once, then lookups are hash based.
+ */
+class IconThemeResolver
+{
+public:
+    IconThemeResolver();
+
+    void clear();
+
+    QString findIcon(const QString &themeName, const QString &iconName, int size, int scale);
+
+private:
+    struct Directory
+    {
+        enum Type {
+            Fixed,
+            Scalable,
+            Threshold
+        };
+
+        Type type = Threshold;
+        int size = 0;
+        int minSize = 0;
+        int maxSize = 0;
+        int threshold = 2;
+        int scale = 1;
+    };
+
+    struct Theme
+    {
+        QStringList parents;
+        QVector<Directory> directories;
+        QHash<QString, QVector<QPair<int, QString> > > icons;
+    };
+
+    QStringList m_baseDirs;
+    QHash<QString, Theme> m_themes;
+
+    const Theme &theme(const QString &themeName);
+    QString lookupIcon(const Theme &theme, const QString &iconName, int size, int scale) const;
+    QString fallbackIcon(const QString &iconName) const;
+
+    static bool directoryMatchesSize(const Directory &directory, int size, int scale);
+    static int directorySizeDistance(const Directory &directory, int size, int scale);
+};
@@ -0,0 +1,276 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMetaEnum>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusError>
+#include <QtQuick/QQuickWindow>
+#include <QtWaylandCompositor/QWaylandBufferRef>
+#include <QtWaylandCompositor/QWaylandCompositor>
+#include <QtWaylandCompositor/QWaylandOutput>
+#include <QtWaylandCompositor/QWaylandSurface>
+#include <QtWaylandCompositor/QWaylandView>
+
+#include "launchstatistics.h"
+
+Q_LOGGING_CATEGORY(LAUNCH_STATISTICS, "liri.launcher.launchstatistics")
+
+/*
+ * Launches that don't show a window within this time are forgotten,
+ * the application probably didn't need one or doesn't talk Wayland
+ */
+#define LAUNCH_TRACKING_TIMEOUT_MS (60 * 1000)
+
+// Upper bounds of the histogram buckets, the last bucket is unbounded
+static const int s_bucketBounds[] = { 50, 100, 200, 400, 800, 1600, 3200, 6400, 12800 };
+static const int s_bucketCount = sizeof(s_bucketBounds) / sizeof(s_bucketBounds[0]) + 1;
+
+static QPointer<LaunchStatistics> s_launchStatistics;
+
+void LaunchStatistics::Histogram::add(qint64 msecs)
+{
+    if (buckets.isEmpty())
+        buckets.fill(0, s_bucketCount);
+
+    min = count == 0 ? msecs : qMin(min, msecs);
+    max = count == 0 ? msecs : qMax(max, msecs);
+    sum += msecs;
+    count++;
+
+    int bucket = 0;
+    while (bucket < s_bucketCount - 1 && msecs > s_bucketBounds[bucket])
+        bucket++;
+    buckets[bucket]++;
+}
+
+QVariantMap LaunchStatistics::Histogram::toVariantMap() const
+{
+    QVariantList counts;
+    for (int value : buckets)
+        counts.append(value);
+
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), count);
+    map.insert(QStringLiteral("sum"), sum);
+    map.insert(QStringLiteral("min"), min);
+    map.insert(QStringLiteral("max"), max);
+    map.insert(QStringLiteral("buckets"), counts);
+    return map;
+}
+
+LaunchStatistics::LaunchStatistics(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerObject(QStringLiteral("/LaunchStatistics"), this,
+                            QDBusConnection::ExportScriptableSlots))
+        qCWarning(LAUNCH_STATISTICS, "Couldn't register /LaunchStatistics D-Bus object: %s",
+                  qPrintable(bus.lastError().message()));
+}
+
+LaunchStatistics *LaunchStatistics::instance()
+{
+    // Unregistered from the bus before the application goes away
+    if (!s_launchStatistics)
+        s_launchStatistics = new LaunchStatistics(QCoreApplication::instance());
+    return s_launchStatistics;
+}
+
+void LaunchStatistics::launchStarted(const QString &appId)
+{
+    Launch launch;
+    for (int i = 0; i < StageCount; ++i)
+        launch.times[i] = -1;
+    launch.times[Click] = m_clock.elapsed();
+
+    // Launching again before the window showed up starts over
+    auto it = m_launches.find(appId);
+    if (it != m_launches.end())
+        drop(it);
+    m_launches.insert(appId, launch);
+
+    // Forget about it even if nothing else happens in the meantime
+    QTimer::singleShot(LAUNCH_TRACKING_TIMEOUT_MS, Qt::PreciseTimer,
+                       this, &LaunchStatistics::prune);
+}
+
+void LaunchStatistics::launchSpawned(const QString &appId)
+{
+    mark(appId, Spawn);
+}
+
+void LaunchStatistics::launchFailed(const QString &appId)
+{
+    auto it = m_launches.find(appId);
+    if (it != m_launches.end())
+        drop(it);
+}
+
+void LaunchStatistics::surfaceRegistered(const QString &appId, QWaylandSurface *surface)
+{
+    auto it = m_launches.find(appId);
+    if (it == m_launches.end() || it->times[FirstSurface] >= 0 || !surface)
+        return;
+
+    mark(appId, FirstSurface);
+    it->surface = surface;
+
+    if (surface->hasContent()) {
+        mark(appId, FirstCommit);
+        watchFirstFrame(appId, surface);
+        return;
+    }
+
+    // Wait for the first buffer
+    it->connection = connect(surface, &QWaylandSurface::hasContentChanged, this, [this, appId, surface] {
+        auto it = m_launches.find(appId);
+        if (it == m_launches.end() || it->surface != surface || !surface->hasContent())
+            return;
+
+        disconnect(it->connection);
+        mark(appId, FirstCommit);
+        watchFirstFrame(appId, surface);
+    });
+}
+
+QList<int> LaunchStatistics::bucketBounds() const
+{
+    QList<int> bounds;
+    for (int i = 0; i < s_bucketCount - 1; ++i)
+        bounds.append(s_bucketBounds[i]);
+    return bounds;
+}
+
+QStringList LaunchStatistics::applications() const
+{
+    return m_histograms.keys();
+}
+
+QVariantMap LaunchStatistics::statistics(const QString &appId) const
+{
+    QVariantMap map;
+
+    auto it = m_histograms.constFind(appId);
+    if (it == m_histograms.constEnd())
+        return map;
+
+    const QMetaEnum stages = QMetaEnum::fromType<Stage>();
+    for (int i = Spawn; i < StageCount; ++i)
+        map.insert(QString::fromLatin1(stages.valueToKey(i)), it->at(i).toVariantMap());
+    return map;
+}
+
+void LaunchStatistics::reset()
+{
+    m_histograms.clear();
+}
+
+void LaunchStatistics::mark(const QString &appId, Stage stage)
+{
+    auto it = m_launches.find(appId);
+    if (it != m_launches.end() && it->times[stage] < 0)
+        it->times[stage] = m_clock.elapsed();
+}
+
+void LaunchStatistics::watchFirstFrame(const QString &appId, QWaylandSurface *surface)
+{
+    // Content is presented by the next frame of the window showing it
+    QWaylandView *view = surface->primaryView();
+    QWaylandOutput *output = view && view->output() ? view->output()
+                                                    : surface->compositor()->defaultOutput();
+    QQuickWindow *window = output ? qobject_cast<QQuickWindow *>(output->window()) : nullptr;
+    if (!window) {
+        finish(appId);
+        return;
+    }
+
+    auto it = m_launches.find(appId);
+    if (it == m_launches.end())
+        return;
+
+    // frameSwapped() comes from the render thread with the threaded render loop
+    it->connection = connect(window, &QQuickWindow::frameSwapped, this, [this, appId] {
+        auto it = m_launches.find(appId);
+        if (it == m_launches.end())
+            return;
+
+        // Frames rendered before the view took the first buffer don't show
+        // the application yet, the view is updated while syncing a frame
+        QWaylandView *view = it->surface ? it->surface->primaryView() : nullptr;
+        if (!view || !view->currentBuffer().hasContent())
+            return;
+
+        mark(appId, FirstFrame);
+        finish(appId);
+    }, Qt::QueuedConnection);
+}
+
+void LaunchStatistics::finish(const QString &appId)
+{
+    auto it = m_launches.find(appId);
+    if (it == m_launches.end())
+        return;
+
+    const Launch launch = *it;
+    drop(it);
+
+    QVector<Histogram> &histograms = m_histograms[appId];
+    if (histograms.isEmpty())
+        histograms.resize(StageCount);
+
+    const QMetaEnum stages = QMetaEnum::fromType<Stage>();
+    QStringList latencies;
+    for (int i = Spawn; i < StageCount; ++i) {
+        if (launch.times[i] < 0)
+            continue;
+
+        const qint64 latency = launch.times[i] - launch.times[Click];
+        histograms[i].add(latency);
+        latencies.append(QStringLiteral("%1 %2 ms").arg(QString::fromLatin1(stages.valueToKey(i))).arg(latency));
+    }
+
+    qCInfo(LAUNCH_STATISTICS, "Launched \"%s\": %s",
+           qPrintable(appId), qPrintable(latencies.join(QStringLiteral(", "))));
+}
+
+QHash<QString, LaunchStatistics::Launch>::iterator LaunchStatistics::drop(QHash<QString, Launch>::iterator it)
+{
+    disconnect(it->connection);
+    return m_launches.erase(it);
+}
+
+void LaunchStatistics::prune()
+{
+    const qint64 now = m_clock.elapsed();
+
+    for (auto it = m_launches.begin(); it != m_launches.end();) {
+        if (now - it->times[Click] >= LAUNCH_TRACKING_TIMEOUT_MS)
+            it = drop(it);
+        else
+            ++it;
+    }
+}
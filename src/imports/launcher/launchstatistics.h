@@ -0,0 +1,107 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QVariantMap>
+#include <QtCore/QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(LAUNCH_STATISTICS)
+
+class QWaylandSurface;
+
+/*!
+ * Launch-to-first-frame latency of applications started from the shell.
+ *
+ * Each launch records when it was requested, when the process was spawned,
+ * when the client registered its first shell surface, when that surface
+ * committed content and when a frame showing that content was presented.
+ * Launches are forgotten when no frame shows up within a minute.
+ * Latencies from the click are aggregated into per-application histograms,
+ * logged and exposed on the session bus as /LaunchStatistics.
+ */
+class LaunchStatistics : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "io.liri.LaunchStatistics")
+public:
+    enum Stage {
+        Click = 0,
+        Spawn,
+        // Stands in for the client connection: clients can only be told
+        // apart from each other once they create a shell surface
+        FirstSurface,
+        FirstCommit,
+        FirstFrame,
+        StageCount
+    };
+    Q_ENUM(Stage)
+
+    explicit LaunchStatistics(QObject *parent = nullptr);
+
+    static LaunchStatistics *instance();
+
+    void launchStarted(const QString &appId);
+    void launchSpawned(const QString &appId);
+    void launchFailed(const QString &appId);
+    void surfaceRegistered(const QString &appId, QWaylandSurface *surface);
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QList<int> bucketBounds() const;
+    Q_SCRIPTABLE QStringList applications() const;
+    Q_SCRIPTABLE QVariantMap statistics(const QString &appId) const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct Histogram {
+        int count = 0;
+        qint64 sum = 0;
+        qint64 min = 0;
+        qint64 max = 0;
+        QVector<int> buckets;
+
+        void add(qint64 msecs);
+        QVariantMap toVariantMap() const;
+    };
+
+    struct Launch {
+        qint64 times[StageCount];
+        QPointer<QWaylandSurface> surface;
+        QMetaObject::Connection connection;
+    };
+
+    QElapsedTimer m_clock;
+    QHash<QString, Launch> m_launches;
+    QHash<QString, QVector<Histogram>> m_histograms;
+
+    void mark(const QString &appId, Stage stage);
+    void watchFirstFrame(const QString &appId, QWaylandSurface *surface);
+    void finish(const QString &appId);
+    QHash<QString, Launch>::iterator drop(QHash<QString, Launch>::iterator it);
+    void prune();
+};
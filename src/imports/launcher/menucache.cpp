@@ -0,0 +1,307 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QLocale>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QStandardPaths>
+#include <QtXml/QDomDocument>
+
+#include <qt5xdg/xdgmenu.h>
+
+#include "menucache.h"
+#include "utils.h"
+
+Q_LOGGING_CATEGORY(MENU_CACHE, "liri.launcher.menucache")
+
+// Bump when the layout changes
+#define MENU_CACHE_MAGIC 0x4c4d4e55
+#define MENU_CACHE_VERSION 3
+
+static qint64 modificationTime(const QString &path)
+{
+    QFileInfo fileInfo(path);
+    return fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+static void addStamp(MenuCacheStamps &stamps, QSet<QString> &seen, const QString &path)
+{
+    if (seen.contains(path))
+        return;
+    seen.insert(path);
+
+    // Missing paths are stamped too, they might appear later
+    stamps.append(qMakePair(path, modificationTime(path)));
+}
+
+static void addDirectoryStamps(MenuCacheStamps &stamps, QSet<QString> &seen, const QString &path,
+                               const QString &nameFilter, bool recursive)
+{
+    if (seen.contains(path))
+        return;
+    addStamp(stamps, seen, path);
+
+    // A directory changes when entries are added or removed, but files
+    // modified in place only change themselves
+    QDir dir(path);
+    const QFileInfoList files = dir.entryInfoList(QStringList() << nameFilter, QDir::Files);
+    for (const QFileInfo &fileInfo : files)
+        addStamp(stamps, seen, fileInfo.absoluteFilePath());
+
+    if (recursive) {
+        const QFileInfoList dirs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QFileInfo &fileInfo : dirs)
+            addDirectoryStamps(stamps, seen, fileInfo.absoluteFilePath(), nameFilter, true);
+    }
+}
+
+static void addMenuFileStamps(MenuCacheStamps &stamps, QSet<QString> &seen, const QString &fileName)
+{
+    if (seen.contains(fileName))
+        return;
+    addStamp(stamps, seen, fileName);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDomDocument document;
+    if (!document.setContent(&file))
+        return;
+
+    // Follow everything XdgMenu reads while merging the menu
+    const QDir baseDir = QFileInfo(fileName).absoluteDir();
+    const QDomNodeList elements = document.elementsByTagName(QStringLiteral("*"));
+    for (int i = 0; i < elements.size(); i++) {
+        const QDomElement e = elements.at(i).toElement();
+        const QString tagName = e.tagName();
+        const QString path = baseDir.absoluteFilePath(e.text().trimmed());
+
+        if (tagName == QLatin1String("MergeFile")) {
+            if (e.attribute(QStringLiteral("type")) == QLatin1String("parent")) {
+                // Same relative path in the following configuration directories
+                const QStringList configDirs =
+                        QStandardPaths::standardLocations(QStandardPaths::GenericConfigLocation);
+                for (const QString &configDir : configDirs)
+                    addMenuFileStamps(stamps, seen, QDir(configDir).absoluteFilePath(
+                                          QStringLiteral("menus/") + QFileInfo(fileName).fileName()));
+            } else {
+                addMenuFileStamps(stamps, seen, path);
+            }
+        } else if (tagName == QLatin1String("MergeDir") || tagName == QLatin1String("DefaultMergeDirs")) {
+            QStringList dirs;
+            if (tagName == QLatin1String("MergeDir")) {
+                dirs.append(path);
+            } else {
+                const QString mergeDirName = QStringLiteral("menus/") +
+                        QFileInfo(fileName).completeBaseName() + QStringLiteral("-merged");
+                const QStringList configDirs =
+                        QStandardPaths::standardLocations(QStandardPaths::GenericConfigLocation);
+                for (const QString &configDir : configDirs)
+                    dirs.append(QDir(configDir).absoluteFilePath(mergeDirName));
+            }
+
+            for (const QString &dirName : qAsConst(dirs)) {
+                addStamp(stamps, seen, dirName);
+                const QFileInfoList files = QDir(dirName).entryInfoList(
+                            QStringList() << QStringLiteral("*.menu"), QDir::Files);
+                for (const QFileInfo &fileInfo : files)
+                    addMenuFileStamps(stamps, seen, fileInfo.absoluteFilePath());
+            }
+        } else if (tagName == QLatin1String("AppDir") || tagName == QLatin1String("LegacyDir")) {
+            addDirectoryStamps(stamps, seen, path, QStringLiteral("*.desktop"), true);
+        } else if (tagName == QLatin1String("DirectoryDir")) {
+            addDirectoryStamps(stamps, seen, path, QStringLiteral("*.directory"), false);
+        }
+    }
+}
+
+static QStringList rootPaths()
+{
+    QStringList paths = xdgApplicationsPaths();
+
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDir : dataDirs) {
+        paths.append(QDir(dataDir).absoluteFilePath(QStringLiteral("desktop-directories")));
+        paths.append(QDir(dataDir).absoluteFilePath(QStringLiteral("applnk")));
+    }
+
+    paths.append(XdgMenu::getMenuFileName());
+
+    return paths;
+}
+
+MenuCacheStamps MenuCache::currentStamps()
+{
+    MenuCacheStamps stamps;
+    QSet<QString> seen;
+
+    // Desktop entries are looked up in subdirectories as well,
+    // KDE legacy directories included
+    const QStringList paths = rootPaths();
+    for (const QString &path : paths) {
+        if (path.endsWith(QLatin1String(".menu")))
+            addMenuFileStamps(stamps, seen, path);
+        else if (path.endsWith(QLatin1String("desktop-directories")))
+            addDirectoryStamps(stamps, seen, path, QStringLiteral("*.directory"), false);
+        else
+            addDirectoryStamps(stamps, seen, path, QStringLiteral("*.desktop"), true);
+    }
+
+    return stamps;
+}
+
+static bool isUpToDate(const MenuCacheStamps &stamps)
+{
+    QSet<QString> stamped;
+
+    for (const auto &stamp : stamps) {
+        if (modificationTime(stamp.first) != stamp.second)
+            return false;
+        stamped.insert(stamp.first);
+    }
+
+    // Search paths might have changed since the cache was written
+    const QStringList paths = rootPaths();
+    for (const QString &path : paths) {
+        if (!stamped.contains(path))
+            return false;
+    }
+
+    return true;
+}
+
+static QDataStream &operator<<(QDataStream &out, const MenuCacheApplication &app)
+{
+    out << app.appId << app.name << app.genericName
+        << app.comment << app.iconName << app.category
+        << app.keywords << app.executable;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, MenuCacheApplication &app)
+{
+    in >> app.appId >> app.name >> app.genericName
+       >> app.comment >> app.iconName >> app.category
+       >> app.keywords >> app.executable;
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const MenuCacheCategory &category)
+{
+    out << category.name << category.title << category.comment << category.iconName;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, MenuCacheCategory &category)
+{
+    in >> category.name >> category.title >> category.comment >> category.iconName;
+    return in;
+}
+
+MenuCache::MenuCache()
+{
+}
+
+QString MenuCache::fileName()
+{
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    return cacheDir.absoluteFilePath(QStringLiteral("liri-shell/menu.cache"));
+}
+
+bool MenuCache::load()
+{
+    applications.clear();
+    categories.clear();
+
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // Map the file instead of reading it, we only go through it once
+    uchar *data = file.map(0, file.size());
+    if (!data)
+        return false;
+
+    const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data),
+                                                     int(file.size()));
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_10);
+
+    quint32 magic = 0, version = 0;
+    QString localeName;
+    MenuCacheStamps stamps;
+    in >> magic >> version;
+    if (magic != MENU_CACHE_MAGIC || version != MENU_CACHE_VERSION) {
+        file.unmap(data);
+        return false;
+    }
+
+    in >> localeName >> stamps;
+    if (localeName != QLocale::system().name() || !isUpToDate(stamps)) {
+        qCDebug(MENU_CACHE) << "Menu cache is stale";
+        file.unmap(data);
+        return false;
+    }
+
+    in >> applications >> categories;
+    file.unmap(data);
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(MENU_CACHE, "Menu cache \"%s\" is corrupted", qPrintable(fileName()));
+        applications.clear();
+        categories.clear();
+        return false;
+    }
+
+    qCDebug(MENU_CACHE) << "Loaded" << applications.size() << "applications and"
+                        << categories.size() << "categories from cache";
+
+    return true;
+}
+
+bool MenuCache::save(const MenuCacheStamps &stamps) const
+{
+    QFileInfo fileInfo(fileName());
+    if (!fileInfo.dir().exists())
+        fileInfo.dir().mkpath(QStringLiteral("."));
+
+    QSaveFile file(fileInfo.absoluteFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(MENU_CACHE, "Unable to write menu cache \"%s\": %s",
+                  qPrintable(file.fileName()), qPrintable(file.errorString()));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_10);
+    out << quint32(MENU_CACHE_MAGIC) << quint32(MENU_CACHE_VERSION);
+    out << QLocale::system().name() << stamps;
+    out << applications << categories;
+
+    return file.commit();
+}
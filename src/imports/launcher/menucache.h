@@ -0,0 +1,100 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(MENU_CACHE)
+
+typedef QVector<QPair<QString, qint64> > MenuCacheStamps;
+
+struct MenuCacheApplication
+{
+    QString appId;
+    QString name;
+    QString genericName;
+    QString comment;
+    QString iconName;
+    QString category;
+    QStringList keywords;
+    QString executable;
+};
+
+struct MenuCacheCategory
+{
+    QString name;
+    QString title;
+    QString comment;
+    QString iconName;
+};
+
+inline bool operator==(const MenuCacheApplication &a, const MenuCacheApplication &b)
+{
+    return a.appId == b.appId && a.name == b.name && a.genericName == b.genericName &&
+            a.comment == b.comment && a.iconName == b.iconName && a.category == b.category &&
+            a.keywords == b.keywords && a.executable == b.executable;
+}
+
+inline bool operator!=(const MenuCacheApplication &a, const MenuCacheApplication &b)
+{
+    return !(a == b);
+}
+
+inline bool operator==(const MenuCacheCategory &a, const MenuCacheCategory &b)
+{
+    return a.name == b.name && a.title == b.title &&
+            a.comment == b.comment && a.iconName == b.iconName;
+}
+
+/*!
+ * On-disk snapshot of the resolved application menu.
+ *
+ * The cache lives in XDG_CACHE_HOME and holds localized names, icon
+ * names and categories of every menu entry, so that launcher models
+ * can be populated at login without parsing the menu.
+ * It is considered stale when the locale or any of the menu files,
+ * directory entries, desktop entries or directories read to build the
+ * menu have been modified since it was written.
+ *
+ * Both load() and currentStamps() stat every one of those files, call
+ * them from a worker thread. Stamps must be taken before the menu is
+ * read, so that files modified meanwhile make the cache stale.
+ */
+class MenuCache
+{
+public:
+    MenuCache();
+
+    static QString fileName();
+    static MenuCacheStamps currentStamps();
+
+    bool load();
+    bool save(const MenuCacheStamps &stamps) const;
+
+    QVector<MenuCacheApplication> applications;
+    QVector<MenuCacheCategory> categories;
+};
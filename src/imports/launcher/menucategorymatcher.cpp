@@ -0,0 +1,189 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+#include <QtXml/QDomDocument>
+
+#include "menucategorymatcher.h"
+
+MenuCategoryMatcher::MenuCategoryMatcher()
+{
+}
+
+bool MenuCategoryMatcher::load(const QString &menuFileName)
+{
+    m_exact = false;
+    m_rules.clear();
+    m_excludedFileNames.clear();
+
+    QFile file(menuFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDomDocument document;
+    if (!document.setContent(&file))
+        return false;
+
+    m_exact = true;
+
+    QDomElement root = document.documentElement();
+    checkUnsupported(root, menuFileName);
+
+    // Includes at the top level would add entries to the root menu
+    if (!root.firstChildElement(QStringLiteral("Include")).isNull())
+        m_exact = false;
+
+    // Entries excluded from the whole menu
+    for (QDomElement e = root.firstChildElement(QStringLiteral("Exclude")); !e.isNull();
+         e = e.nextSiblingElement(QStringLiteral("Exclude"))) {
+        QSet<QString> categories;
+        parseMatches(e, categories, m_excludedFileNames);
+        if (!categories.isEmpty())
+            m_exact = false;
+    }
+
+    for (QDomElement menu = root.firstChildElement(QStringLiteral("Menu")); !menu.isNull();
+         menu = menu.nextSiblingElement(QStringLiteral("Menu"))) {
+        // Nested submenus are not supported
+        if (!menu.firstChildElement(QStringLiteral("Menu")).isNull())
+            m_exact = false;
+        checkUnsupported(menu, menuFileName);
+
+        Rule rule;
+        rule.name = menu.firstChildElement(QStringLiteral("Name")).text();
+
+        // Include and Exclude are applied in the order they appear
+        for (QDomElement e = menu.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+            const bool include = e.tagName() == QLatin1String("Include");
+            if (!include && e.tagName() != QLatin1String("Exclude"))
+                continue;
+
+            Match match;
+            match.include = include;
+            parseMatches(e, match.categories, match.fileNames);
+            rule.matches.append(match);
+        }
+
+        m_rules.append(rule);
+    }
+
+    return true;
+}
+
+void MenuCategoryMatcher::setMenuOrder(const QStringList &names)
+{
+    // Submenus that are not in the list go last, in file order
+    std::stable_sort(m_rules.begin(), m_rules.end(), [&names](const Rule &a, const Rule &b) {
+        const int indexA = names.indexOf(a.name);
+        const int indexB = names.indexOf(b.name);
+        if (indexA < 0 || indexB < 0)
+            return indexA >= 0 && indexB < 0;
+        return indexA < indexB;
+    });
+}
+
+QString MenuCategoryMatcher::categoryFor(const QString &fileName, const QStringList &categories) const
+{
+    const QString baseName = QFileInfo(fileName).fileName();
+
+    if (m_excludedFileNames.contains(baseName))
+        return QString();
+
+    for (const Rule &rule : qAsConst(m_rules)) {
+        bool included = false;
+        for (const Match &match : rule.matches) {
+            // Only rules that would change the outcome need to be matched
+            if (included == match.include)
+                continue;
+
+            bool matched = match.fileNames.contains(baseName);
+            for (int i = 0; !matched && i < categories.size(); ++i)
+                matched = match.categories.contains(categories.at(i));
+            if (matched)
+                included = match.include;
+        }
+
+        if (included)
+            return rule.name;
+    }
+
+    return QString();
+}
+
+void MenuCategoryMatcher::parseMatches(const QDomElement &element, QSet<QString> &categories,
+                                       QSet<QString> &fileNames)
+{
+    for (QDomElement e = element.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+        if (e.tagName() == QLatin1String("Category"))
+            categories.insert(e.text().trimmed());
+        else if (e.tagName() == QLatin1String("Filename"))
+            fileNames.insert(e.text().trimmed());
+        else if (e.tagName() == QLatin1String("Or"))
+            parseMatches(e, categories, fileNames);
+        else
+            m_exact = false;
+    }
+}
+
+void MenuCategoryMatcher::checkUnsupported(const QDomElement &menu, const QString &menuFileName)
+{
+    const QDir baseDir = QFileInfo(menuFileName).absoluteDir();
+    const QStringList configDirs = QStandardPaths::standardLocations(QStandardPaths::GenericConfigLocation);
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    const QStringList menuFilter = QStringList() << QStringLiteral("*.menu");
+
+    for (QDomElement e = menu.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+        const QString tagName = e.tagName();
+
+        if (tagName == QLatin1String("AppDir") || tagName == QLatin1String("LegacyDir") ||
+                tagName == QLatin1String("OnlyUnallocated") || tagName == QLatin1String("Deleted") ||
+                tagName == QLatin1String("Move")) {
+            m_exact = false;
+        } else if (tagName == QLatin1String("MergeFile")) {
+            // XdgMenu ignores merge files that don't exist
+            if (e.attribute(QStringLiteral("type")) == QLatin1String("parent") ||
+                    QFileInfo::exists(baseDir.absoluteFilePath(e.text().trimmed())))
+                m_exact = false;
+        } else if (tagName == QLatin1String("MergeDir")) {
+            if (!QDir(baseDir.absoluteFilePath(e.text().trimmed())).entryList(menuFilter, QDir::Files).isEmpty())
+                m_exact = false;
+        } else if (tagName == QLatin1String("DefaultMergeDirs")) {
+            const QString mergeDirName = QStringLiteral("menus/") +
+                    QFileInfo(menuFileName).completeBaseName() + QStringLiteral("-merged");
+            for (const QString &configDir : configDirs) {
+                if (!QDir(QDir(configDir).absoluteFilePath(mergeDirName)).entryList(menuFilter, QDir::Files).isEmpty())
+                    m_exact = false;
+            }
+        } else if (tagName == QLatin1String("KDELegacyDirs")) {
+            for (const QString &dataDir : dataDirs) {
+                if (QFileInfo::exists(QDir(dataDir).absoluteFilePath(QStringLiteral("applnk"))))
+                    m_exact = false;
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class QDomElement;
+
+/*!
+ * Resolves the menu category of a single desktop entry using the
+ * Include and Exclude rules of the menu file, without building the
+ * whole menu.
+ *
+ * Only the subset of the menu specification used by our menu file is
+ * supported: Category and Filename matches, optionally wrapped into Or.
+ * When the menu file uses anything else, including merges, application
+ * directories, OnlyUnallocated and Deleted that have any effect,
+ * isExact() returns false and callers must fall back to a full XdgMenu
+ * parse.
+ *
+ * Include and Exclude rules are applied in document order, so that an
+ * entry excluded by a rule can be included again by a later one.
+ *
+ * Entries belong to the first submenu that includes them, callers pass
+ * the order of the submenus in the menu built by XdgMenu to
+ * setMenuOrder() so that the same submenu is picked.
+ */
+class MenuCategoryMatcher
+{
+public:
+    MenuCategoryMatcher();
+
+    bool load(const QString &menuFileName);
+
+    bool isExact() const { return m_exact; }
+
+    void setMenuOrder(const QStringList &names);
+
+    QString categoryFor(const QString &fileName, const QStringList &categories) const;
+
+private:
+    struct Match
+    {
+        bool include = true;
+        QSet<QString> categories;
+        QSet<QString> fileNames;
+    };
+
+    struct Rule
+    {
+        QString name;
+        QVector<Match> matches;
+    };
+
+    bool m_exact = false;
+    QVector<Rule> m_rules;
+    QSet<QString> m_excludedFileNames;
+
+    void parseMatches(const QDomElement &element, QSet<QString> &categories,
+                      QSet<QString> &fileNames);
+    void checkUnsupported(const QDomElement &menu, const QString &menuFileName);
+};
@@ -0,0 +1,404 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QPointer>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <qt5xdg/xdgdesktopfile.h>
+#include <qt5xdg/xdgmenu.h>
+#include <qt5xdg/xmlhelper.h>
+
+#include "menucategorymatcher.h"
+#include "menuindex.h"
+#include "utils.h"
+
+Q_LOGGING_CATEGORY(MENU_INDEX, "liri.launcher.menuindex")
+
+// Package upgrades touch many files in a row, wait for things to settle
+#define RESCAN_DELAY_MS 500
+
+static QPointer<MenuIndex> s_menuIndex;
+
+static QStringList menuEnvironments()
+{
+    return QStringList() << QStringLiteral("Liri") << QStringLiteral("X-Liri");
+}
+
+static bool isShownInMenu(const XdgDesktopFile &desktopFile)
+{
+    // Same as XdgMenu: shown if any of our environment names allows it
+    const QStringList environments = menuEnvironments();
+    for (const QString &environment : environments) {
+        if (desktopFile.isShown(environment))
+            return true;
+    }
+    return false;
+}
+
+static MenuCacheApplication entryFromDesktopFile(const QString &appId, const QString &categoryName,
+                                                 const XdgDesktopFile &desktopFile)
+{
+    MenuCacheApplication entry;
+    entry.appId = appId;
+    entry.name = desktopFile.name();
+    entry.genericName = desktopFile.localizedValue(QStringLiteral("GenericName")).toString();
+    entry.comment = desktopFile.comment();
+    entry.iconName = desktopFile.iconName();
+    entry.category = categoryName;
+    entry.keywords = desktopFile.localizedValue(QStringLiteral("Keywords")).toString()
+            .split(QLatin1Char(';'), QString::SkipEmptyParts);
+
+    // Only the program name is useful for searching
+    const QString exec = desktopFile.value(QStringLiteral("Exec")).toString();
+    entry.executable = QFileInfo(exec.section(QLatin1Char(' '), 0, 0, QString::SectionSkipEmpty)).fileName();
+
+    return entry;
+}
+
+MenuIndex::MenuIndex(QObject *parent)
+    : QObject(parent)
+{
+    m_rescanTimer = new QTimer(this);
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(RESCAN_DELAY_MS);
+    connect(m_rescanTimer, &QTimer::timeout, this, &MenuIndex::rescan);
+
+    // Start empty, the cache is validated and loaded on a worker thread
+    m_snapshot = MenuSnapshot(new MenuCache());
+    watchScan(QtConcurrent::run(MenuIndex::load));
+
+    QFileSystemWatcher *watcher = new QFileSystemWatcher(this);
+    watcher->addPaths(xdgApplicationsPaths());
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+        m_pendingDirs.insert(path);
+        m_rescanTimer->start();
+    });
+}
+
+MenuIndex *MenuIndex::instance()
+{
+    // Watchers and timers must go away before the application does
+    if (!s_menuIndex)
+        s_menuIndex = new MenuIndex(QCoreApplication::instance());
+    return s_menuIndex;
+}
+
+MenuSnapshot MenuIndex::snapshot() const
+{
+    return m_snapshot;
+}
+
+MenuIndex::Scan MenuIndex::load()
+{
+    // Start from the cache, if it's still valid, otherwise parse the whole menu
+    MenuCache *cache = new MenuCache();
+    if (!cache->load()) {
+        delete cache;
+        return parse();
+    }
+
+    Scan scan;
+    scan.snapshot = MenuSnapshot(cache);
+    scan.times = scanEntryTimes(xdgApplicationsPaths());
+    return scan;
+}
+
+MenuIndex::Scan MenuIndex::parse()
+{
+    // Remember modification times to find out what changed later on,
+    // anything touched while we parse will be picked up by the next scan
+    const DesktopEntryTimes times = scanEntryTimes(xdgApplicationsPaths());
+    const MenuCacheStamps stamps = MenuCache::currentStamps();
+
+    MenuCache *cache = new MenuCache();
+    if (!readMenu(cache)) {
+        delete cache;
+        return Scan();
+    }
+
+    // Next time we can start from here
+    cache->save(stamps);
+
+    Scan scan;
+    scan.snapshot = MenuSnapshot(cache);
+    scan.times = times;
+    return scan;
+}
+
+MenuIndex::Scan MenuIndex::parseEntries(const MenuSnapshot &snapshot, const QStringList &dirs,
+                                        const DesktopEntryTimes &knownTimes)
+{
+    const DesktopEntryTimes times = scanEntryTimes(dirs);
+    const MenuCacheStamps stamps = MenuCache::currentStamps();
+
+    // Find out which entries were added, removed or modified
+    QSet<QString> changedAppIds;
+    for (const QString &dir : dirs) {
+        const QHash<QString, qint64> before = knownTimes.value(dir);
+        const QHash<QString, qint64> after = times.value(dir);
+
+        for (auto it = before.constBegin(); it != before.constEnd(); ++it) {
+            if (after.value(it.key(), -1) != it.value())
+                changedAppIds.insert(QFileInfo(it.key()).completeBaseName());
+        }
+        for (auto it = after.constBegin(); it != after.constEnd(); ++it) {
+            if (!before.contains(it.key()))
+                changedAppIds.insert(QFileInfo(it.key()).completeBaseName());
+        }
+    }
+
+    qCDebug(MENU_INDEX) << "Desktop entries changed:" << changedAppIds;
+
+    MenuCategoryMatcher matcher;
+    if (!matcher.load(XdgMenu::getMenuFileName()) || !matcher.isExact()) {
+        // Menu rules are too complex to be evaluated one entry at a time
+        qCDebug(MENU_INDEX, "Falling back to a full menu refresh");
+        return parse();
+    }
+
+    // Categories are in the order of the menu built by XdgMenu
+    QStringList menuOrder;
+    for (const MenuCacheCategory &category : snapshot->categories)
+        menuOrder.append(category.name);
+    matcher.setMenuOrder(menuOrder);
+
+    // Changed entries are dropped and added back if they still belong to the menu
+    MenuCache *cache = new MenuCache(*snapshot);
+    auto it = cache->applications.begin();
+    while (it != cache->applications.end()) {
+        if (changedAppIds.contains(it->appId))
+            it = cache->applications.erase(it);
+        else
+            ++it;
+    }
+
+    for (const QString &appId : qAsConst(changedAppIds)) {
+        // The entry with the highest precedence wins
+        const QString desktopFileName =
+                QStandardPaths::locate(QStandardPaths::ApplicationsLocation,
+                                       appId + QStringLiteral(".desktop"));
+        if (desktopFileName.isEmpty())
+            continue;
+
+        XdgDesktopFile desktopFile;
+        if (!desktopFile.load(desktopFileName) || !desktopFile.isValid() ||
+                !isShownInMenu(desktopFile))
+            continue;
+
+        const QString categoryName = matcher.categoryFor(desktopFileName, desktopFile.categories());
+        if (categoryName.isEmpty())
+            continue;
+
+        // Empty submenus are dropped from the menu, only a full parse brings them back
+        if (!menuOrder.contains(categoryName)) {
+            qCDebug(MENU_INDEX, "Submenu \"%s\" is new, falling back to a full menu refresh",
+                    qPrintable(categoryName));
+            delete cache;
+            return parse();
+        }
+
+        cache->applications.append(entryFromDesktopFile(appId, categoryName, desktopFile));
+    }
+
+    cache->save(stamps);
+
+    Scan scan;
+    scan.snapshot = MenuSnapshot(cache);
+    scan.times = times;
+    return scan;
+}
+
+bool MenuIndex::readMenu(MenuCache *cache)
+{
+    // Avoid adding duplicate entries
+    QSet<QString> addedEntries;
+
+    XdgMenu xdgMenu;
+    //xdgMenu.setLogDir("/tmp/");
+    xdgMenu.setEnvironments(menuEnvironments());
+
+    const QString menuFileName = XdgMenu::getMenuFileName();
+
+    qCDebug(MENU_INDEX) << "Menu file name:" << menuFileName;
+    if (!xdgMenu.read(menuFileName)) {
+        qCWarning(MENU_INDEX, "Failed to read menu \"%s\": %s",
+                  qPrintable(menuFileName),
+                  qPrintable(xdgMenu.errorString()));
+        return false;
+    }
+
+    QDomElement xml = xdgMenu.xml().documentElement();
+
+    DomElementIterator it(xml, QString());
+    while (it.hasNext()) {
+        QDomElement xml = it.next();
+
+        if (xml.tagName() == QStringLiteral("Menu")) {
+            QString categoryName = xml.attribute(QStringLiteral("name"));
+
+            MenuCacheCategory category;
+            category.name = categoryName;
+            category.title = xml.attribute(QStringLiteral("title"));
+            category.comment = xml.attribute(QStringLiteral("comment"));
+            category.iconName = xml.attribute(QStringLiteral("icon"));
+            cache->categories.append(category);
+
+            DomElementIterator it(xml, QString());
+            while (it.hasNext()) {
+                QDomElement xml = it.next();
+
+                if (xml.tagName() == QStringLiteral("AppLink")) {
+                    QString desktopFileName = xml.attribute(QStringLiteral("desktopFile"));
+                    QString appId = QFileInfo(desktopFileName).completeBaseName();
+
+                    // Ignore desktop files that do not exists
+                    desktopFileName =
+                            QStandardPaths::locate(QStandardPaths::ApplicationsLocation,
+                                                   appId + QStringLiteral(".desktop"));
+                    if (!QFileInfo::exists(desktopFileName))
+                        continue;
+
+                    // Keep track of added entries to avoid duplicates
+                    if (addedEntries.contains(appId))
+                        continue;
+                    addedEntries.insert(appId);
+
+                    // Add only valid apps
+                    XdgDesktopFile desktopFile;
+                    if (!desktopFile.load(desktopFileName))
+                        continue;
+                    if (!desktopFile.isValid())
+                        continue;
+
+                    cache->applications.append(entryFromDesktopFile(appId, categoryName, desktopFile));
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+DesktopEntryTimes MenuIndex::scanEntryTimes(const QStringList &dirs)
+{
+    DesktopEntryTimes times;
+
+    for (const QString &path : dirs) {
+        QHash<QString, qint64> &entries = times[path];
+
+        QDir dir(path);
+        const QFileInfoList list =
+                dir.entryInfoList(QStringList() << QStringLiteral("*.desktop"), QDir::Files);
+        for (const QFileInfo &fileInfo : list)
+            entries.insert(fileInfo.absoluteFilePath(), fileInfo.lastModified().toMSecsSinceEpoch());
+    }
+
+    return times;
+}
+
+void MenuIndex::watchScan(const QFuture<Scan> &future)
+{
+    // The watcher is our child, results of a scan that outlives us are dropped
+    QFutureWatcher<Scan> *watcher = new QFutureWatcher<Scan>(this);
+    connect(watcher, &QFutureWatcher<Scan>::finished, this, [this, watcher] {
+        const Scan scan = watcher->result();
+        watcher->deleteLater();
+
+        if (scan.snapshot)
+            publish(scan.snapshot, scan.times);
+        else
+            finishScan(scan.times);
+    });
+    watcher->setFuture(future);
+}
+
+void MenuIndex::publish(const MenuSnapshot &snapshot, const DesktopEntryTimes &times)
+{
+    const MenuSnapshot previous = m_snapshot;
+    m_snapshot = snapshot;
+
+    // Diff the two snapshots, subscribers only hear about what changed
+    QHash<QString, const MenuCacheApplication *> before;
+    for (const MenuCacheApplication &entry : previous->applications)
+        before.insert(entry.appId, &entry);
+
+    QVector<MenuCacheApplication> added, changed;
+    for (const MenuCacheApplication &entry : snapshot->applications) {
+        const MenuCacheApplication *old = before.take(entry.appId);
+        if (!old)
+            added.append(entry);
+        else if (*old != entry)
+            changed.append(entry);
+    }
+
+    qCDebug(MENU_INDEX) << "Menu index updated:" << added.size() << "added,"
+                        << changed.size() << "changed," << before.size() << "removed";
+
+    for (auto it = before.constBegin(); it != before.constEnd(); ++it)
+        Q_EMIT applicationRemoved(it.key());
+    for (const MenuCacheApplication &entry : qAsConst(changed))
+        Q_EMIT applicationChanged(entry);
+    for (const MenuCacheApplication &entry : qAsConst(added))
+        Q_EMIT applicationAdded(entry);
+    if (previous->categories != snapshot->categories)
+        Q_EMIT categoriesChanged();
+
+    finishScan(times);
+
+    Q_EMIT refreshed();
+}
+
+void MenuIndex::finishScan(const DesktopEntryTimes &times)
+{
+    for (auto it = times.constBegin(); it != times.constEnd(); ++it)
+        m_entryTimes.insert(it.key(), it.value());
+
+    m_scanning = false;
+    if (!m_pendingDirs.isEmpty())
+        m_rescanTimer->start();
+}
+
+void MenuIndex::rescan()
+{
+    // Wait for the previous scan to finish, it will reschedule us
+    if (m_scanning || m_pendingDirs.isEmpty())
+        return;
+
+    const QStringList dirs = m_pendingDirs.toList();
+    m_pendingDirs.clear();
+    m_scanning = true;
+
+    Q_EMIT refreshing();
+
+    watchScan(QtConcurrent::run(MenuIndex::parseEntries, m_snapshot, dirs, m_entryTimes));
+}
+
+#include "moc_menuindex.cpp"
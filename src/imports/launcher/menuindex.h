@@ -0,0 +1,99 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QFuture>
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
+
+#include "menucache.h"
+
+class QTimer;
+
+Q_DECLARE_LOGGING_CATEGORY(MENU_INDEX)
+
+typedef QSharedPointer<const MenuCache> MenuSnapshot;
+typedef QHash<QString, QHash<QString, qint64> > DesktopEntryTimes;
+
+/*!
+ * Process-wide index of the application menu.
+ *
+ * The menu is parsed once per change on a worker thread and published
+ * as an immutable snapshot, models read the current snapshot when they
+ * are created and follow the per-entry signals afterwards.
+ * Applications directories are watched here and only here.
+ *
+ * The index is owned by the application, workers hand their results
+ * back through a QFutureWatcher so that a scan still running when the
+ * application quits is simply dropped.
+ */
+class MenuIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MenuIndex(QObject *parent = nullptr);
+
+    static MenuIndex *instance();
+
+    MenuSnapshot snapshot() const;
+
+Q_SIGNALS:
+    void refreshing();
+    void refreshed();
+    void applicationAdded(const MenuCacheApplication &entry);
+    void applicationChanged(const MenuCacheApplication &entry);
+    void applicationRemoved(const QString &appId);
+    void categoriesChanged();
+
+private:
+    struct Scan
+    {
+        // Null when the menu couldn't be read
+        MenuSnapshot snapshot;
+        DesktopEntryTimes times;
+    };
+
+    MenuSnapshot m_snapshot;
+    QTimer *m_rescanTimer = nullptr;
+    QSet<QString> m_pendingDirs;
+    DesktopEntryTimes m_entryTimes;
+    bool m_scanning = true;
+
+    static Scan load();
+    static Scan parse();
+    static Scan parseEntries(const MenuSnapshot &snapshot, const QStringList &dirs,
+                             const DesktopEntryTimes &knownTimes);
+    static bool readMenu(MenuCache *cache);
+    static DesktopEntryTimes scanEntryTimes(const QStringList &dirs);
+
+    void watchScan(const QFuture<Scan> &future);
+    void publish(const MenuSnapshot &snapshot, const DesktopEntryTimes &times);
+    void finishScan(const DesktopEntryTimes &times);
+
+private Q_SLOTS:
+    void rescan();
+};
@@ -26,26 +26,100 @@
 #include <QtCore/QtGlobal>
 
 PageModel::PageModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractProxyModel(parent)
 {
 }
 
-bool PageModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+int PageModel::startIndex() const { return m_startIndex; }
+
+int PageModel::limitCount() const { return m_limitCount; }
+
+void PageModel::setSourceModel(QAbstractItemModel *newSourceModel)
 {
-    Q_UNUSED(sourceParent);
+    beginResetModel();
+
+    if (sourceModel())
+        disconnect(sourceModel(), nullptr, this, nullptr);
+
+    QAbstractProxyModel::setSourceModel(newSourceModel);
+
+    if (newSourceModel) {
+        connect(newSourceModel, &QAbstractItemModel::rowsInserted,
+                this, &PageModel::handleRowsInserted);
+        connect(newSourceModel, &QAbstractItemModel::rowsRemoved,
+                this, &PageModel::handleRowsRemoved);
+        connect(newSourceModel, &QAbstractItemModel::dataChanged,
+                this, &PageModel::handleDataChanged);
 
-    return sourceRow >= m_startIndex && sourceRow < m_startIndex + m_limitCount;
+        // Anything could have moved, but we only have a page to refresh
+        connect(newSourceModel, &QAbstractItemModel::modelAboutToBeReset,
+                this, &PageModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::modelReset, this, [this] {
+            m_rowCount = windowCount();
+            endResetModel();
+        });
+        connect(newSourceModel, &QAbstractItemModel::layoutAboutToBeChanged,
+                this, &PageModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::layoutChanged, this, [this] {
+            m_rowCount = windowCount();
+            endResetModel();
+        });
+        connect(newSourceModel, &QAbstractItemModel::rowsAboutToBeMoved,
+                this, &PageModel::beginResetModel);
+        connect(newSourceModel, &QAbstractItemModel::rowsMoved, this, [this] {
+            m_rowCount = windowCount();
+            endResetModel();
+        });
+    }
+
+    m_rowCount = windowCount();
+    endResetModel();
 }
 
-int PageModel::startIndex() const { return m_startIndex; }
+QModelIndex PageModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!sourceModel() || !proxyIndex.isValid())
+        return QModelIndex();
+    return sourceModel()->index(m_startIndex + proxyIndex.row(), proxyIndex.column());
+}
 
-int PageModel::limitCount() const { return m_limitCount; }
+QModelIndex PageModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+    return index(sourceIndex.row() - m_startIndex, sourceIndex.column());
+}
+
+QModelIndex PageModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= m_rowCount || column != 0)
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex PageModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int PageModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int PageModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
 
 void PageModel::setStartIndex(int startIndex)
 {
     if (startIndex != m_startIndex) {
+        beginResetModel();
         m_startIndex = startIndex;
-        invalidateFilter();
+        m_rowCount = windowCount();
+        endResetModel();
         Q_EMIT startIndexChanged();
     }
 }
@@ -53,8 +127,88 @@ void PageModel::setStartIndex(int startIndex)
 void PageModel::setLimitCount(int limitCount)
 {
     if (limitCount != m_limitCount) {
+        beginResetModel();
         m_limitCount = limitCount;
-        invalidateFilter();
+        m_rowCount = windowCount();
+        endResetModel();
         Q_EMIT limitCountChanged();
     }
 }
+
+int PageModel::windowCount() const
+{
+    if (!sourceModel())
+        return 0;
+    return qBound(0, sourceModel()->rowCount() - m_startIndex, m_limitCount);
+}
+
+/*
+ * Grow or shrink at the end after rows have been inserted or removed
+ * before the end of the window.
+ */
+void PageModel::resize()
+{
+    const int count = windowCount();
+
+    if (count > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, count - 1);
+        m_rowCount = count;
+        endInsertRows();
+    } else if (count < m_rowCount) {
+        beginRemoveRows(QModelIndex(), count, m_rowCount - 1);
+        m_rowCount = count;
+        endRemoveRows();
+    }
+}
+
+void PageModel::handleRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    const int end = m_startIndex + m_limitCount;
+    if (parent.isValid() || first >= end)
+        return;
+
+    // Rows inserted before the window push everything in from the front
+    const int row = qMax(first, m_startIndex) - m_startIndex;
+    const int count = qMin(last - first + 1, m_limitCount - row);
+
+    if (count > 0) {
+        beginInsertRows(QModelIndex(), row, row + count - 1);
+        m_rowCount += count;
+        endInsertRows();
+    }
+
+    resize();
+}
+
+void PageModel::handleRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    const int end = m_startIndex + m_limitCount;
+    if (parent.isValid() || first >= end)
+        return;
+
+    // Rows removed before the window pull everything out from the front
+    const int row = qMax(first, m_startIndex) - m_startIndex;
+    const int count = qMin(last - first + 1, m_rowCount - row);
+
+    if (count > 0) {
+        beginRemoveRows(QModelIndex(), row, row + count - 1);
+        m_rowCount -= count;
+        endRemoveRows();
+    }
+
+    resize();
+}
+
+void PageModel::handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                  const QVector<int> &roles)
+{
+    if (topLeft.parent().isValid())
+        return;
+
+    const int first = qMax(topLeft.row(), m_startIndex) - m_startIndex;
+    const int last = qMin(bottomRight.row() - m_startIndex, m_rowCount - 1);
+    if (first > last)
+        return;
+
+    Q_EMIT dataChanged(index(first, 0), index(last, 0), roles);
+}
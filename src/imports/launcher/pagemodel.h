@@ -23,14 +23,17 @@
 
 #pragma once
 
-#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QAbstractProxyModel>
 #include <QtQml/QQmlComponent>
 
 /**
  * Provides a simple proxy model for accessing a subset, or "page," of data from a source model.
  * This is used by PagedGrid to provide models to each page with the appropriate subset of data.
+ *
+ * Rows map directly to the source window starting at startIndex, only source changes that
+ * affect the window are forwarded.
  */
-class PageModel : public QSortFilterProxyModel
+class PageModel : public QAbstractProxyModel
 {
     Q_OBJECT
     Q_PROPERTY(int startIndex READ startIndex WRITE setStartIndex NOTIFY startIndexChanged)
@@ -42,7 +45,16 @@ public:
     int startIndex() const;
     int limitCount() const;
 
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
 public Q_SLOTS:
     void setStartIndex(int startIndex);
@@ -55,6 +67,15 @@ Q_SIGNALS:
 private:
     int m_startIndex = 0;
     int m_limitCount = 0;
+    int m_rowCount = 0;
+
+    int windowCount() const;
+    void resize();
+
+    void handleRowsInserted(const QModelIndex &parent, int first, int last);
+    void handleRowsRemoved(const QModelIndex &parent, int first, int last);
+    void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                           const QVector<int> &roles);
 };
 
 QML_DECLARE_TYPE(PageModel)
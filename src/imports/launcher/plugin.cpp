@@ -30,9 +30,13 @@
 #include "applicationmanager.h"
 #include "categoriesmodel.h"
 #include "frequentmodel.h"
+#include "iconcache.h"
+#include "iconimageprovider.h"
 #include "launchermodel.h"
+#include "launchstatistics.h"
 #include "pagemodel.h"
 #include "processrunner.h"
+#include "searchmodel.h"
 
 class LauncherPlugin : public QQmlExtensionPlugin
 {
@@ -40,6 +44,18 @@ class LauncherPlugin : public QQmlExtensionPlugin
     Q_PLUGIN_METADATA(IID "org.qt-project.Qt.QQmlExtensionInterface")
 
 public:
+    void initializeEngine(QQmlEngine *engine, const char *uri)
+    {
+        Q_UNUSED(uri);
+
+        // Create the cache on the main thread, before any image is requested
+        IconCache::instance();
+        engine->addImageProvider(IconCache::providerName(), new IconImageProvider());
+
+        // Export launch statistics on the bus right away
+        LaunchStatistics::instance();
+    }
+
     void registerTypes(const char *uri)
     {
         // @uri Liri.Launcher
@@ -51,6 +67,12 @@ public:
         qmlRegisterType<PageModel>(uri, 1, 0, "PageModel");
         qmlRegisterType<FrequentAppsModel>(uri, 1, 0, "FrequentAppsModel");
         qmlRegisterType<ProcessRunner>(uri, 1, 0, "ProcessRunner");
+        qmlRegisterType<SearchModel>(uri, 1, 0, "SearchModel");
+        qmlRegisterSingletonType<IconCache>(uri, 1, 0, "IconCache",
+                                            [](QQmlEngine *, QJSEngine *) -> QObject * {
+            QQmlEngine::setObjectOwnership(IconCache::instance(), QQmlEngine::CppOwnership);
+            return IconCache::instance();
+        });
         qmlRegisterUncreatableType<Application>(uri, 1, 0, "Application",
                                                 QStringLiteral("Cannot instantiate Application"));
         qmlRegisterUncreatableType<DesktopFileAction>(uri, 1, 0, "DesktopFileAction",
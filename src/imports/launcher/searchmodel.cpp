@@ -0,0 +1,390 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QTimer>
+
+#include <algorithm>
+
+#include "application.h"
+#include "applicationmanager.h"
+#include "menuindex.h"
+#include "searchmodel.h"
+#include "usagetracker.h"
+
+/*
+ * Length of the n-grams tokens are indexed by, shorter terms
+ * are matched against the beginning of tokens only
+ */
+#define SEARCH_NGRAM_SIZE 3
+
+// Indexed by SearchModel::Field
+static const int fieldWeights[] = { 16, 8, 6, 4, 1 };
+
+SearchModel::SearchModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    connect(m_searchTimer, &QTimer::timeout, this, &SearchModel::search);
+
+    // Ranking depends on usage too
+    connect(UsageTracker::instance(), &UsageTracker::updated, this, [this] {
+        if (!m_matchedQuery.isEmpty())
+            m_searchTimer->start();
+    });
+
+    connect(this, &SearchModel::rowsInserted, this, &SearchModel::countChanged);
+    connect(this, &SearchModel::rowsRemoved, this, &SearchModel::countChanged);
+    connect(this, &SearchModel::modelReset, this, &SearchModel::countChanged);
+    connect(this, &SearchModel::layoutChanged, this, &SearchModel::countChanged);
+
+    setSortLocaleAware(true);
+    sort(0);
+}
+
+QString SearchModel::query() const
+{
+    return m_query;
+}
+
+void SearchModel::setQuery(const QString &query)
+{
+    if (m_query == query)
+        return;
+
+    m_query = query;
+    search();
+    Q_EMIT queryChanged();
+}
+
+QString SearchModel::category() const
+{
+    return m_category;
+}
+
+void SearchModel::setCategory(const QString &category)
+{
+    if (m_category == category)
+        return;
+
+    m_category = category;
+    invalidateFilter();
+    Q_EMIT categoryChanged();
+}
+
+int SearchModel::count() const
+{
+    return rowCount();
+}
+
+void SearchModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (this->sourceModel())
+        disconnect(this->sourceModel(), nullptr, this, nullptr);
+
+    m_appMan = qobject_cast<ApplicationManager *>(sourceModel);
+
+    // Connected before the proxy model, so that matches are up to date
+    // by the time it filters the rows
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &SearchModel::handleRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &SearchModel::handleRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &SearchModel::handleRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &SearchModel::handleRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &SearchModel::handleRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this,
+                [this](const QModelIndex &, const QModelIndex &, const QVector<int> &roles) {
+            // Running state and such do not affect the index
+            if (roles.isEmpty() || roles.contains(ApplicationManager::NameRole) ||
+                    roles.contains(ApplicationManager::GenericNameRole) ||
+                    roles.contains(ApplicationManager::CommentRole))
+                invalidateIndex();
+        });
+    }
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+
+    invalidateIndex();
+}
+
+Application *SearchModel::get(int row) const
+{
+    if (!m_appMan)
+        return nullptr;
+
+    QModelIndex sourceIndex = mapToSource(index(row, 0));
+    return m_appMan->get(sourceIndex.row());
+}
+
+bool SearchModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    const QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
+
+    if (!m_category.isEmpty()) {
+        const QStringList categories =
+                sourceIndex.data(ApplicationManager::CategoriesRole).toStringList();
+        if (!categories.contains(m_category, Qt::CaseInsensitive))
+            return false;
+    }
+
+    if (m_matchedQuery.isEmpty())
+        return true;
+    return m_matches.contains(sourceRow);
+}
+
+bool SearchModel::lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const
+{
+    // Best matches first, most used applications break ties
+    if (!m_matchedQuery.isEmpty()) {
+        const Match left = m_matches.value(sourceLeft.row());
+        const Match right = m_matches.value(sourceRight.row());
+
+        if (left.score != right.score)
+            return left.score > right.score;
+        if (left.usage != right.usage)
+            return left.usage > right.usage;
+    }
+
+    const QString leftName = sourceLeft.data(ApplicationManager::NameRole).toString();
+    const QString rightName = sourceRight.data(ApplicationManager::NameRole).toString();
+    return QString::localeAwareCompare(leftName, rightName) < 0;
+}
+
+QStringList SearchModel::tokenize(const QString &text)
+{
+    QStringList tokens;
+    QString token;
+
+    for (const QChar &c : text) {
+        if (c.isLetterOrNumber()) {
+            token.append(c.toLower());
+        } else if (!token.isEmpty()) {
+            tokens.append(token);
+            token.clear();
+        }
+    }
+    if (!token.isEmpty())
+        tokens.append(token);
+
+    return tokens;
+}
+
+void SearchModel::rebuildIndex()
+{
+    m_tokens.clear();
+    m_rowTokens.clear();
+    m_trigrams.clear();
+    m_matchedQuery.clear();
+    m_indexDirty = false;
+
+    if (!sourceModel())
+        return;
+
+    // Keywords and executables are only known by the menu
+    const MenuSnapshot snapshot = MenuIndex::instance()->snapshot();
+    QHash<QString, const MenuCacheApplication *> entries;
+    for (const MenuCacheApplication &entry : snapshot->applications)
+        entries.insert(entry.appId, &entry);
+
+    const int rows = sourceModel()->rowCount();
+    m_rowTokens.resize(rows);
+
+    for (int row = 0; row < rows; row++) {
+        const QModelIndex sourceIndex = sourceModel()->index(row, 0);
+
+        addTokens(row, NameField,
+                  tokenize(sourceIndex.data(ApplicationManager::NameRole).toString()));
+        addTokens(row, GenericNameField,
+                  tokenize(sourceIndex.data(ApplicationManager::GenericNameRole).toString()));
+        addTokens(row, CommentField,
+                  tokenize(sourceIndex.data(ApplicationManager::CommentRole).toString()));
+
+        const QString appId = sourceIndex.data(ApplicationManager::AppIdRole).toString();
+        const MenuCacheApplication *entry = entries.value(appId);
+        if (entry) {
+            addTokens(row, KeywordsField, tokenize(entry->keywords.join(QLatin1Char(' '))));
+            addTokens(row, ExecutableField, tokenize(entry->executable));
+        }
+    }
+}
+
+void SearchModel::addTokens(int row, Field field, const QStringList &texts)
+{
+    for (int i = 0; i < texts.size(); i++) {
+        Token token;
+        token.text = texts.at(i);
+        token.row = row;
+        token.field = field;
+        token.leading = i == 0;
+
+        const int id = m_tokens.size();
+        m_tokens.append(token);
+        m_rowTokens[row].append(id);
+
+        // Posting lists are sorted since ids only grow
+        for (int j = 0; j + SEARCH_NGRAM_SIZE <= token.text.size(); j++) {
+            QVector<int> &ids = m_trigrams[token.text.mid(j, SEARCH_NGRAM_SIZE)];
+            if (ids.isEmpty() || ids.last() != id)
+                ids.append(id);
+        }
+    }
+}
+
+int SearchModel::matchToken(const Token &token, const QString &term) const
+{
+    const int pos = token.text.indexOf(term);
+    if (pos < 0)
+        return 0;
+    if (pos > 0 && term.size() < SEARCH_NGRAM_SIZE)
+        return 0;
+
+    // Prefer words starting with the term, even more so at the beginning
+    int score = fieldWeights[token.field];
+    if (pos == 0)
+        score *= token.leading ? 4 : 2;
+    return score;
+}
+
+QHash<int, int> SearchModel::matchTerm(const QString &term, const QHash<int, Match> *candidates) const
+{
+    QHash<int, int> scores;
+
+    auto consider = [this, &term, &scores](int id) {
+        const Token &token = m_tokens.at(id);
+        const int score = matchToken(token, term);
+        if (score > scores.value(token.row))
+            scores.insert(token.row, score);
+    };
+
+    if (candidates) {
+        for (auto it = candidates->constBegin(); it != candidates->constEnd(); ++it) {
+            for (int id : m_rowTokens.at(it.key()))
+                consider(id);
+        }
+    } else if (term.size() < SEARCH_NGRAM_SIZE) {
+        for (int id = 0; id < m_tokens.size(); id++)
+            consider(id);
+    } else {
+        // Tokens containing the term contain all of its n-grams
+        QVector<const QVector<int> *> lists;
+        for (int i = 0; i + SEARCH_NGRAM_SIZE <= term.size(); i++) {
+            auto it = m_trigrams.constFind(term.mid(i, SEARCH_NGRAM_SIZE));
+            if (it == m_trigrams.constEnd())
+                return scores;
+            lists.append(&it.value());
+        }
+
+        std::sort(lists.begin(), lists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+            return a->size() < b->size();
+        });
+
+        QVector<int> ids = *lists.first();
+        for (int i = 1; i < lists.size() && !ids.isEmpty(); i++) {
+            QVector<int> common;
+            std::set_intersection(ids.constBegin(), ids.constEnd(),
+                                  lists.at(i)->constBegin(), lists.at(i)->constEnd(),
+                                  std::back_inserter(common));
+            ids = common;
+        }
+
+        for (int id : qAsConst(ids))
+            consider(id);
+    }
+
+    return scores;
+}
+
+void SearchModel::search()
+{
+    m_searchTimer->stop();
+
+    updateMatches();
+    invalidate();
+}
+
+void SearchModel::updateMatches()
+{
+    const QStringList terms = tokenize(m_query);
+    if (terms.isEmpty()) {
+        m_matchedQuery.clear();
+        m_matches.clear();
+        return;
+    }
+
+    if (m_indexDirty)
+        rebuildIndex();
+
+    // Matches can only get fewer as the query grows, unless the last term
+    // just became long enough to be matched anywhere within a token
+    bool narrow = false;
+    if (!m_matchedQuery.isEmpty() && m_query.startsWith(m_matchedQuery)) {
+        const QStringList previousTerms = tokenize(m_matchedQuery);
+        narrow = previousTerms.last().size() >= SEARCH_NGRAM_SIZE ||
+                terms.last().size() < SEARCH_NGRAM_SIZE;
+    }
+
+    // Every term must match, scores add up
+    QHash<int, Match> matches = narrow ? m_matches : QHash<int, Match>();
+    for (int i = 0; i < terms.size(); i++) {
+        const bool restricted = narrow || i > 0;
+        const QHash<int, int> scores = matchTerm(terms.at(i), restricted ? &matches : nullptr);
+
+        QHash<int, Match> termMatches;
+        for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+            Match match;
+            match.score = (i > 0 ? matches.value(it.key()).score : 0) + it.value();
+            termMatches.insert(it.key(), match);
+        }
+        matches = termMatches;
+    }
+
+    for (auto it = matches.begin(); it != matches.end(); ++it) {
+        const QString appId = sourceModel()->index(it.key(), 0).data(ApplicationManager::AppIdRole).toString();
+        AppUsage *usage = UsageTracker::instance()->usageForAppId(appId);
+        it.value().usage = usage ? usage->score : 0;
+    }
+
+    m_matchedQuery = m_query;
+    m_matches = matches;
+}
+
+void SearchModel::invalidateIndex()
+{
+    m_indexDirty = true;
+
+    // Names changed, look everything up again
+    if (!m_matchedQuery.isEmpty())
+        m_searchTimer->start();
+}
+
+void SearchModel::handleRowsChanged()
+{
+    m_indexDirty = true;
+
+    // Matches are keyed by source row, look them up again right away
+    // because the proxy model filters inserted rows as soon as we return
+    if (!m_matchedQuery.isEmpty()) {
+        m_searchTimer->stop();
+        updateMatches();
+    }
+}
@@ -0,0 +1,123 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QSortFilterProxyModel>
+#include <QtCore/QVector>
+#include <QtQml/QQmlComponent>
+
+class QTimer;
+class Application;
+class ApplicationManager;
+
+/*!
+ * Filters and ranks applications for the launcher search field.
+ *
+ * Names, generic names, keywords, executables and comments are split
+ * into lowercase tokens and indexed by trigram, so that each keystroke
+ * only verifies the tokens sharing all trigrams with the query.
+ * When the query grows only rows that matched before are considered.
+ * Results are ordered by match quality first and usage score next.
+ */
+class SearchModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(QString category READ category WRITE setCategory NOTIFY categoryChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+    explicit SearchModel(QObject *parent = nullptr);
+
+    QString query() const;
+    void setQuery(const QString &query);
+
+    QString category() const;
+    void setCategory(const QString &category);
+
+    int count() const;
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    Q_INVOKABLE Application *get(int row) const;
+
+Q_SIGNALS:
+    void queryChanged();
+    void categoryChanged();
+    void countChanged();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const override;
+
+private:
+    // Sorted by relevance
+    enum Field {
+        NameField = 0,
+        GenericNameField,
+        KeywordsField,
+        ExecutableField,
+        CommentField
+    };
+
+    struct Token
+    {
+        QString text;
+        int row;
+        Field field;
+        bool leading;
+    };
+
+    struct Match
+    {
+        int score = 0;
+        int usage = 0;
+    };
+
+    ApplicationManager *m_appMan = nullptr;
+    QString m_query;
+    QString m_category;
+
+    QVector<Token> m_tokens;
+    QVector<QVector<int> > m_rowTokens;
+    QHash<QString, QVector<int> > m_trigrams;
+    bool m_indexDirty = true;
+
+    QString m_matchedQuery;
+    QHash<int, Match> m_matches;
+    QTimer *m_searchTimer = nullptr;
+
+    static QStringList tokenize(const QString &text);
+
+    void rebuildIndex();
+    void addTokens(int row, Field field, const QStringList &texts);
+    int matchToken(const Token &token, const QString &term) const;
+    QHash<int, int> matchTerm(const QString &term, const QHash<int, Match> *candidates) const;
+    void search();
+    void updateMatches();
+    void invalidateIndex();
+    void handleRowsChanged();
+};
+
+QML_DECLARE_TYPE(SearchModel)
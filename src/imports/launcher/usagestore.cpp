@@ -0,0 +1,117 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QVariant>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+#include <QtSql/QSqlRecord>
+
+#include "usagestore.h"
+#include "usagetracker.h"
+
+UsageStore::UsageStore(QObject *parent)
+    : QObject(parent)
+{
+}
+
+UsageStore::~UsageStore()
+{
+    if (m_db.isOpen())
+        m_db.close();
+}
+
+void UsageStore::open(const QString &fileName)
+{
+    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("app_usage"));
+    m_db.setDatabaseName(fileName);
+
+    if (!m_db.open()) {
+        qCWarning(USAGE_TRACKER, "Unable to open database: %s",
+                  qPrintable(m_db.lastError().text()));
+        Q_EMIT loaded(QVector<UsageRecord>());
+        return;
+    } else {
+        qCDebug(USAGE_TRACKER) << "Database opened:" << m_db.databaseName();
+    }
+
+    // Readers never wait for us and commits don't fsync the main file
+    QSqlQuery pragma(m_db);
+    pragma.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+    pragma.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+
+    QSqlQuery create(QStringLiteral("CREATE TABLE IF NOT EXISTS app_usage (id TEXT PRIMARY KEY, last_seen INTEGER, "
+                                    "score INTEGER)"),
+                     m_db);
+
+    QVector<UsageRecord> records;
+
+    QSqlQuery query(QStringLiteral("SELECT * from app_usage"), m_db);
+    QSqlRecord rec = query.record();
+
+    int idColumn = rec.indexOf(QStringLiteral("id"));
+    int lastSeenColumn = rec.indexOf(QStringLiteral("last_seen"));
+    int scoreColumn = rec.indexOf(QStringLiteral("score"));
+
+    while (query.next()) {
+        UsageRecord record;
+        record.appId = query.value(idColumn).toString();
+        record.lastSeen.setTime_t(query.value(lastSeenColumn).toInt());
+        record.score = query.value(scoreColumn).toInt();
+        records.append(record);
+    }
+
+    Q_EMIT loaded(records);
+}
+
+void UsageStore::write(const QVector<UsageRecord> &records, const QStringList &removedAppIds)
+{
+    if (!m_db.isOpen())
+        return;
+
+    m_db.transaction();
+
+    QSqlQuery query(m_db);
+    query.prepare(QStringLiteral("INSERT OR REPLACE INTO app_usage VALUES (:id, :last_seen, :score)"));
+    for (const UsageRecord &record : records) {
+        query.bindValue(QStringLiteral(":id"), record.appId);
+        query.bindValue(QStringLiteral(":last_seen"), record.lastSeen.toTime_t());
+        query.bindValue(QStringLiteral(":score"), record.score);
+        query.exec();
+    }
+
+    query.prepare(QStringLiteral("DELETE FROM app_usage WHERE id = :id"));
+    for (const QString &appId : removedAppIds) {
+        query.bindValue(QStringLiteral(":id"), appId);
+        query.exec();
+    }
+
+    if (!m_db.commit()) {
+        qCWarning(USAGE_TRACKER, "Unable to save application usage: %s",
+                  qPrintable(m_db.lastError().text()));
+        m_db.rollback();
+        return;
+    }
+
+    qCDebug(USAGE_TRACKER) << "Saved" << records.size() << "usage records, removed"
+                           << removedAppIds.size();
+}
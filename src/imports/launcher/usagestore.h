@@ -0,0 +1,63 @@
+/****************************************************************************
+ * This file is part of Liri.
+ *
+ * Copyright (C) 2018 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL3+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#pragma once
+
+#include <QtCore/QDateTime>
+#include <QtCore/QMetaType>
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+#include <QtSql/QSqlDatabase>
+
+struct UsageRecord
+{
+    QString appId;
+    QDateTime lastSeen;
+    int score = 0;
+};
+
+Q_DECLARE_METATYPE(UsageRecord)
+
+/*!
+ * Owns the usage database, lives on UsageTracker's worker thread.
+ *
+ * Writes arrive in batches and are committed in a single transaction,
+ * the journal is kept in WAL mode so that commits are cheap.
+ */
+class UsageStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UsageStore(QObject *parent = nullptr);
+    ~UsageStore();
+
+Q_SIGNALS:
+    void loaded(const QVector<UsageRecord> &records);
+
+public Q_SLOTS:
+    void open(const QString &fileName);
+    void write(const QVector<UsageRecord> &records, const QStringList &removedAppIds);
+
+private:
+    QSqlDatabase m_db;
+};
@@ -26,12 +26,12 @@
 
 #include "usagetracker.h"
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QStandardPaths>
-#include <QtCore/QVariant>
-#include <QtSql/QSqlError>
-#include <QtSql/QSqlQuery>
-#include <QtSql/QSqlRecord>
+#include <QtCore/QTimer>
+
+#include <algorithm>
 
 /*
  * USAGE ALGORITHM
@@ -65,7 +65,8 @@
 #define IDLE_TIME_TRANSITION_SECONDS 30
 
 /*
- * How often we save internally app data, in seconds
+ * How often we save internally app data, in seconds: changes are
+ * batched and written by a worker thread
  */
 #define SAVE_APPS_TIMEOUT_SECONDS (5 * 60)
 
@@ -85,40 +86,50 @@ Q_LOGGING_CATEGORY(USAGE_TRACKER, "liri.usage")
 
 Q_GLOBAL_STATIC(UsageTracker, s_usageTracker)
 
-UsageTracker::UsageTracker(QObject *parent)
-    : QObject(parent)
+static bool rankedBefore(const AppUsage *app1, const AppUsage *app2)
 {
-    openDatabase();
-    migrate();
-    loadUsage();
-    cleanUsage();
+    if (app1->score != app2->score)
+        return app1->score > app2->score;
+    return app1->appId < app2->appId;
 }
 
-void UsageTracker::openDatabase()
+UsageTracker::UsageTracker(QObject *parent)
+    : QObject(parent)
 {
+    qRegisterMetaType<UsageRecord>("UsageRecord");
+    qRegisterMetaType<QVector<UsageRecord> >("QVector<UsageRecord>");
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(SAVE_APPS_TIMEOUT_SECONDS * 1000);
+    connect(m_flushTimer, &QTimer::timeout, this, &UsageTracker::flush);
+
+    // The database is only ever touched by the store thread
+    m_store = new UsageStore();
+    m_store->moveToThread(&m_storeThread);
+    connect(&m_storeThread, &QThread::finished, m_store, &QObject::deleteLater);
+    connect(m_store, &UsageStore::loaded, this, &UsageTracker::handleLoaded);
+    m_storeThread.setObjectName(QStringLiteral("UsageStore"));
+    m_storeThread.start(QThread::LowPriority);
+
     QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
 
     if (!dataDir.exists()) {
         dataDir.mkpath(QStringLiteral("."));
     }
 
-    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("app_usage"));
-    m_db.setDatabaseName(dataDir.filePath(QStringLiteral("app_usage.db")));
+    QMetaObject::invokeMethod(m_store, "open",
+                              Q_ARG(QString, dataDir.filePath(QStringLiteral("app_usage.db"))));
 
-    if (!m_db.open()) {
-        qCWarning(USAGE_TRACKER, "Unable to open database: %s",
-                  qPrintable(m_db.lastError().text()));
-        return;
-    } else {
-        qCDebug(USAGE_TRACKER) << "Database opened:" << m_db.databaseName();
-    }
+    // Write what's left before going away
+    if (QCoreApplication::instance())
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                this, &UsageTracker::shutdown);
 }
 
-void UsageTracker::migrate()
+UsageTracker::~UsageTracker()
 {
-    QSqlQuery query("CREATE TABLE IF NOT EXISTS app_usage (id TEXT PRIMARY KEY, last_seen INTEGER, "
-                    "score INTEGER)",
-                    m_db);
+    shutdown();
 }
 
 /*
@@ -157,7 +168,8 @@ void UsageTracker::sessionIdleStateChanged(bool isIdle)
     if (isIdle) {
         QDateTime endTime = QDateTime::currentDateTime().addSecs(IDLE_TIME_TRANSITION_SECONDS);
 
-        incrementUsageForApp(m_watchedApp, endTime);
+        if (m_watchedApp)
+            incrementUsageForApp(m_watchedApp, endTime);
     } else {
         m_watchStartTime = QDateTime::currentDateTime();
     }
@@ -169,8 +181,10 @@ void UsageTracker::sessionIdleStateChanged(bool isIdle)
  */
 void UsageTracker::normalizeScores()
 {
-    for (AppUsage *app : qAsConst(m_apps))
+    for (AppUsage *app : qAsConst(m_apps)) {
         app->score /= 2;
+        scheduleSave(app);
+    }
 }
 
 void UsageTracker::incrementUsageForApp(AppUsage *app)
@@ -193,39 +207,46 @@ void UsageTracker::incrementUsageForApp(AppUsage *app, const QDateTime &time)
     if (usageScore > 0) {
         app->score += usageScore;
 
-        if (app->score > SCORE_MAX)
+        // Halving may turn different scores into ties, start over
+        if (app->score > SCORE_MAX) {
             normalizeScores();
+            rebuildRanking();
+        } else {
+            updateRank(app);
+        }
 
-        app->save();
+        scheduleSave(app);
 
         Q_EMIT updated();
     }
 }
 
 /*
- * Load application usage from the SQLite database.
+ * Merge application usage loaded from the SQLite database, applications
+ * might have been used already while it was loading.
  */
-void UsageTracker::loadUsage()
+void UsageTracker::handleLoaded(const QVector<UsageRecord> &records)
 {
-    Q_ASSERT(m_apps.isEmpty());
-
-    QSqlQuery query(QStringLiteral("SELECT * from app_usage"), m_db);
-    QSqlRecord rec = query.record();
-
-    int idColumn = rec.indexOf(QStringLiteral("id"));
-    int lastSeenColumn = rec.indexOf(QStringLiteral("last_seen"));
-    int scoreColumn = rec.indexOf(QStringLiteral("score"));
-
-    while (query.next()) {
-        QDateTime lastSeen;
-        lastSeen.setTime_t(query.value(lastSeenColumn).toInt());
+    for (const UsageRecord &record : records) {
+        AppUsage *app = usageForAppId(record.appId, false);
+        if (app) {
+            app->score += record.score;
+            if (record.lastSeen > app->lastSeen)
+                app->lastSeen = record.lastSeen;
+            scheduleSave(app);
+        } else {
+            app = new AppUsage(record.appId, this);
+            app->lastSeen = record.lastSeen;
+            app->score = record.score;
+            m_apps << app;
+            m_appsById.insert(app->appId, app);
+        }
+    }
 
-        AppUsage *app = new AppUsage(query.value(idColumn).toString(), this);
-        app->lastSeen = lastSeen;
-        app->score = query.value(scoreColumn).toInt();
+    cleanUsage();
+    rebuildRanking();
 
-        m_apps << app;
-    }
+    Q_EMIT updated();
 }
 
 /*
@@ -236,11 +257,17 @@ void UsageTracker::cleanUsage()
 {
     QDateTime weekAgo = QDateTime::currentDateTime().addDays(-7);
 
-    for (AppUsage *app : qAsConst(m_apps)) {
-        if (app->score < SCORE_MIN && app->lastSeen < weekAgo) {
-            m_apps.removeOne(app);
-            app->destroy();
+    auto it = m_apps.begin();
+    while (it != m_apps.end()) {
+        AppUsage *app = *it;
+        if (app != m_watchedApp && app->score < SCORE_MIN && app->lastSeen < weekAgo) {
+            it = m_apps.erase(it);
+            m_appsById.remove(app->appId);
+            m_ranking.removeOne(app);
+            scheduleRemoval(app);
             delete app;
+        } else {
+            ++it;
         }
     }
 }
@@ -250,21 +277,149 @@ AppUsage *UsageTracker::usageForAppId(const QString &appId, bool createIfNew)
     if (appId.isEmpty())
         return nullptr;
 
-    for (AppUsage *app : qAsConst(m_apps)) {
-        if (app->appId == appId)
-            return app;
-    }
+    AppUsage *app = m_appsById.value(appId);
+    if (app || !createIfNew)
+        return app;
 
-    if (!createIfNew)
-        return nullptr;
-
-    AppUsage *app = new AppUsage(appId, this);
+    app = new AppUsage(appId, this);
     m_apps << app;
+    m_appsById.insert(appId, app);
 
     return app;
 }
 
+int UsageTracker::rankForAppId(const QString &appId) const
+{
+    AppUsage *app = m_appsById.value(appId);
+    return app ? app->rank : -1;
+}
+
+/*
+ * Move an application within the ranking after its score changed, only
+ * applications between the old and new position change rank.
+ */
+void UsageTracker::updateRank(AppUsage *app)
+{
+    const int from = app->rank;
+    if (from >= 0)
+        m_ranking.removeAt(from);
+
+    int to = -1;
+    if (app->score > 0) {
+        auto it = std::lower_bound(m_ranking.begin(), m_ranking.end(), app, rankedBefore);
+        to = int(it - m_ranking.begin());
+        m_ranking.insert(to, app);
+    }
+
+    if (from == to)
+        return;
+
+    QStringList changed;
+    changed.append(app->appId);
+    app->rank = to;
+
+    // Without a previous or new position everything after the other one shifts
+    int first = from < 0 ? to : to < 0 ? from : qMin(from, to);
+    int last = from < 0 || to < 0 ? m_ranking.size() - 1 : qMax(from, to);
+    for (int i = first; i <= last; i++) {
+        AppUsage *other = m_ranking.at(i);
+        if (other->rank != i) {
+            other->rank = i;
+            changed.append(other->appId);
+        }
+    }
+
+    Q_EMIT ranksChanged(changed);
+}
+
+void UsageTracker::rebuildRanking()
+{
+    QVector<AppUsage *> ranking;
+    for (AppUsage *app : qAsConst(m_apps)) {
+        if (app->score > 0)
+            ranking.append(app);
+    }
+    std::sort(ranking.begin(), ranking.end(), rankedBefore);
+    m_ranking = ranking;
+
+    QStringList changed;
+    for (int i = 0; i < m_ranking.size(); i++) {
+        AppUsage *app = m_ranking.at(i);
+        if (app->rank != i) {
+            app->rank = i;
+            changed.append(app->appId);
+        }
+    }
+    for (AppUsage *app : qAsConst(m_apps)) {
+        if (app->score <= 0 && app->rank != -1) {
+            app->rank = -1;
+            changed.append(app->appId);
+        }
+    }
+
+    if (!changed.isEmpty())
+        Q_EMIT ranksChanged(changed);
+}
+
 UsageTracker *UsageTracker::instance()
 {
     return s_usageTracker;
 }
+
+void UsageTracker::scheduleSave(AppUsage *app)
+{
+    UsageRecord record;
+    record.appId = app->appId;
+    record.lastSeen = app->lastSeen;
+    record.score = app->score;
+    m_pendingRecords.insert(app->appId, record);
+    m_pendingRemovals.removeOne(app->appId);
+
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void UsageTracker::scheduleRemoval(AppUsage *app)
+{
+    m_pendingRecords.remove(app->appId);
+    m_pendingRemovals.append(app->appId);
+
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void UsageTracker::writePending(Qt::ConnectionType type)
+{
+    m_flushTimer->stop();
+
+    if (m_pendingRecords.isEmpty() && m_pendingRemovals.isEmpty())
+        return;
+
+    // Hand the batch over, the store commits it in one transaction
+    QMetaObject::invokeMethod(m_store, "write", type,
+                              Q_ARG(QVector<UsageRecord>, m_pendingRecords.values().toVector()),
+                              Q_ARG(QStringList, m_pendingRemovals));
+    m_pendingRecords.clear();
+    m_pendingRemovals.clear();
+}
+
+void UsageTracker::flush()
+{
+    writePending(Qt::QueuedConnection);
+}
+
+void UsageTracker::shutdown()
+{
+    if (!m_storeThread.isRunning())
+        return;
+
+    // Account for the application being used right now
+    if (m_watchedApp)
+        incrementUsageForApp(m_watchedApp);
+    m_watchedApp = nullptr;
+
+    // Wait for the last batch, we are about to go away
+    writePending(Qt::BlockingQueuedConnection);
+    m_storeThread.quit();
+    m_storeThread.wait();
+}
@@ -29,12 +29,16 @@
 #include <QtCore/QObject>
 
 #include <QtCore/QDateTime>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
-#include <QtSql/QSqlDatabase>
+#include <QtCore/QThread>
 
 #include "appusage.h"
+#include "usagestore.h"
 
-Q_DECLARE_LOGGING_CATEGORY(SESSION_MANAGER)
+class QTimer;
+
+Q_DECLARE_LOGGING_CATEGORY(USAGE_TRACKER)
 
 class UsageTracker : public QObject
 {
@@ -42,6 +46,7 @@ class UsageTracker : public QObject
 
 public:
     UsageTracker(QObject *parent = nullptr);
+    ~UsageTracker();
 
     void applicationFocused(const QString &appId);
 
@@ -54,8 +59,11 @@ public:
 
     inline AppUsage *usageForAppId(const QString &appId) { return usageForAppId(appId, false); }
 
+    int rankForAppId(const QString &appId) const;
+
 Q_SIGNALS:
     void updated();
+    void ranksChanged(const QStringList &appIds);
 
 private:
     void normalizeScores();
@@ -63,17 +71,32 @@ private:
     void incrementUsageForApp(AppUsage *app);
     void incrementUsageForApp(AppUsage *app, const QDateTime &time);
 
-    void openDatabase();
-    void migrate();
-    void loadUsage();
     void cleanUsage();
 
     AppUsage *usageForAppId(const QString &appId, bool createIfNew);
 
+    void updateRank(AppUsage *app);
+    void rebuildRanking();
+
+    void scheduleSave(AppUsage *app);
+    void scheduleRemoval(AppUsage *app);
+    void writePending(Qt::ConnectionType type);
+
     QList<AppUsage *> m_apps;
+    QHash<QString, AppUsage *> m_appsById;
+    QVector<AppUsage *> m_ranking;
     AppUsage *m_watchedApp = nullptr;
     QDateTime m_watchStartTime;
     bool m_isIdle = false;
 
-    QSqlDatabase m_db;
+    QThread m_storeThread;
+    UsageStore *m_store = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QHash<QString, UsageRecord> m_pendingRecords;
+    QStringList m_pendingRemovals;
+
+private Q_SLOTS:
+    void handleLoaded(const QVector<UsageRecord> &records);
+    void flush();
+    void shutdown();
 };
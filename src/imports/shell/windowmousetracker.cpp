@@ -22,7 +22,9 @@
  ***************************************************************************/
 
 #include <QtCore/QPointer>
+#include <QtCore/QTimer>
 #include <QtGui/QGuiApplication>
+#include <QtGui/QScreen>
 #include <QtQuick/QQuickWindow>
 
 #include "windowmousetracker.h"
@@ -39,6 +41,9 @@ public:
         QImage cursorImage(64, 64, QImage::Format_ARGB32);
         cursorImage.fill(Qt::transparent);
         cursorPixmap = QPixmap::fromImage(cursorImage);
+
+        flushTimer.setSingleShot(true);
+        flushTimer.setTimerType(Qt::PreciseTimer);
     }
 
     void reparentOverlay()
@@ -68,18 +73,38 @@ public:
 
     void handleMouseMove(const QPointF &mousePos)
     {
-        Q_Q(WindowMouseTracker);
+        pendingMousePos = mousePos;
+        positionPending = true;
+
+        // A mouse with a high polling rate sends many more events than
+        // frames we render: report right away when no frame is being
+        // rendered, otherwise only the last position once it's swapped
+        if (window.isNull() || !window->isExposed() || !frameInFlight) {
+            flush();
+        } else if (!flushTimer.isActive()) {
+            // Frames with nothing new to show are never swapped
+            flushTimer.start(frameInterval());
+        }
+    }
 
-        bool xChanged = mousePos.x() != this->mousePos.x();
-        bool yChanged = mousePos.y() != this->mousePos.y();
+    int frameInterval() const
+    {
+        const qreal refreshRate = window->screen() ? window->screen()->refreshRate() : 0;
+        return refreshRate > 0 ? qRound(1000 / refreshRate) : 16;
+    }
+
+    void flush()
+    {
+        Q_Q(WindowMouseTracker);
 
-        if (xChanged || yChanged) {
-            this->mousePos = mousePos;
+        flushTimer.stop();
 
-            if (xChanged)
-                Q_EMIT q->mouseXChanged();
-            if (yChanged)
-                Q_EMIT q->mouseYChanged();
+        if (positionPending) {
+            positionPending = false;
+            if (pendingMousePos != mousePos) {
+                mousePos = pendingMousePos;
+                Q_EMIT q->mousePositionChanged();
+            }
         }
     }
 
@@ -117,9 +142,15 @@ public:
     }
 
     QPointer<QQuickWindow> window;
+    QMetaObject::Connection frameConnection;
+    QMetaObject::Connection swapConnection;
+    QTimer flushTimer;
     bool containsMouse;
     bool windowSystemCursorEnabled;
+    bool frameInFlight = false;
+    bool positionPending = false;
     QPointF mousePos;
+    QPointF pendingMousePos;
     QPixmap cursorPixmap;
 
 private:
@@ -135,6 +166,11 @@ WindowMouseTracker::WindowMouseTracker(QQuickItem *parent)
     setAcceptHoverEvents(true);
     setAcceptedMouseButtons(Qt::NoButton);
 
+    connect(&d->flushTimer, &QTimer::timeout, this, [d] {
+        d->frameInFlight = false;
+        d->flush();
+    });
+
     // QtQuick Controls 2 ApplicationWindow has an overlay on top of your
     // scene so we cannot use regular WaylandMouseTracker to track
     // mouse cursor position, but we can track the local position inside
@@ -144,12 +180,26 @@ WindowMouseTracker::WindowMouseTracker(QQuickItem *parent)
         // Remove event filter previously installed, if any
         if (!d->window.isNull()) {
             d->window->removeEventFilter(this);
+            disconnect(d->frameConnection);
+            disconnect(d->swapConnection);
             d->window.clear();
         }
 
+        // Deliver what is left before switching window
+        d->frameInFlight = false;
+        d->flush();
+
         // Install this event filter when the item is on the window
         if (window) {
             window->installEventFilter(this);
+            d->frameConnection = connect(window, &QQuickWindow::afterAnimating, this, [d] {
+                d->frameInFlight = true;
+            });
+            // Swaps come from the render thread, the connection is queued
+            d->swapConnection = connect(window, &QQuickWindow::frameSwapped, this, [d] {
+                d->frameInFlight = false;
+                d->flush();
+            });
             d->window = window;
             d->reparentOverlay();
             d->setWindowSystemCursorEnabled(d->windowSystemCursorEnabled);
@@ -174,6 +224,12 @@ qreal WindowMouseTracker::mouseY() const
     return d->mousePos.y();
 }
 
+QPointF WindowMouseTracker::mousePosition() const
+{
+    Q_D(const WindowMouseTracker);
+    return d->mousePos;
+}
+
 bool WindowMouseTracker::containsMouse() const
 {
     Q_D(const WindowMouseTracker);
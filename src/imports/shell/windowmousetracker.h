@@ -30,8 +30,9 @@ class WindowMouseTrackerPrivate;
 class WindowMouseTracker : public QQuickItem
 {
     Q_OBJECT
-    Q_PROPERTY(qreal mouseX READ mouseX NOTIFY mouseXChanged)
-    Q_PROPERTY(qreal mouseY READ mouseY NOTIFY mouseYChanged)
+    Q_PROPERTY(qreal mouseX READ mouseX NOTIFY mousePositionChanged)
+    Q_PROPERTY(qreal mouseY READ mouseY NOTIFY mousePositionChanged)
+    Q_PROPERTY(QPointF mousePosition READ mousePosition NOTIFY mousePositionChanged)
     Q_PROPERTY(bool containsMouse READ containsMouse NOTIFY containsMouseChanged)
     Q_PROPERTY(bool windowSystemCursorEnabled READ windowSystemCursorEnabled WRITE setWindowSystemCursorEnabled NOTIFY windowSystemCursorEnabledChanged)
     Q_DECLARE_PRIVATE(WindowMouseTracker)
@@ -41,6 +42,7 @@ public:
 
     qreal mouseX() const;
     qreal mouseY() const;
+    QPointF mousePosition() const;
 
     bool containsMouse() const;
 
@@ -48,8 +50,7 @@ public:
     void setWindowSystemCursorEnabled(bool enable);
 
 Q_SIGNALS:
-    void mouseXChanged();
-    void mouseYChanged();
+    void mousePositionChanged();
     void containsMouseChanged();
     void windowSystemCursorEnabledChanged();
 